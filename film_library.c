@@ -1,11 +1,13 @@
 // Copyright 2025 Rose Laird
 
 #include <stdio.h>
-#include <stdlib.h>  // for malloc, free
+#include <stdlib.h>  // for exit
 #include <string.h>  // for memcpy
 #include <omp.h>  // for OpenMP parallelization
 #include <sys/sysinfo.h>
 #include "film_library.h"  // for function declarations
+#include "film_library_simd.h"  // for the dispatched pixel kernels
+#include "film_library_pool.h"  // for pool_acquire, pool_release
 #include <sys/mman.h>  // for memory mapping
 #include <fcntl.h>  // for file control options
 #include <unistd.h>  // for file I/O
@@ -14,6 +16,34 @@
 #include <stdint.h>  // for int64_t type
 
 
+size_t frame_size(const VideoMetadata *metadata) {
+    size_t planeSize = metadata->height * metadata->width;
+    if ((metadata->format & FORMAT_CHROMA_MASK) == FORMAT_CHROMA_420
+            && metadata->channels == 3) {
+        // Full resolution luma, chroma halved in both directions
+        size_t chromaSize = ((metadata->height + 1) / 2)
+                          * ((metadata->width + 1) / 2);
+        return planeSize + 2 * chromaSize;
+    }
+    return planeSize * metadata->channels;
+}
+
+void update_metadata(FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width) {
+    // Rewrite the frame count and dimensions in place, keeping the
+    // format and channel bytes written by the caller
+    VideoMetadata metadata = {.numFrames = numFrames,
+                              .height = height, .width = width};
+    unsigned char *bytes = (unsigned char *)&metadata;
+    fseek(outputFile, 0, SEEK_SET);
+    if (fwrite(bytes, 1, 7, outputFile) != 7
+            || fseek(outputFile, 9, SEEK_SET) != 0
+            || fwrite(bytes + 9, 1, 2, outputFile) != 2) {
+        perror("Error writing metadata");
+        exit(1);
+    }
+}
+
 void reverse(FILE *inputFile, FILE *outputFile,
         int64_t numFrames, unsigned char height,
         unsigned char width, unsigned char channels) {
@@ -21,7 +51,7 @@ void reverse(FILE *inputFile, FILE *outputFile,
     size_t frameSize = height * width * channels;
     size_t fileSize = numFrames * frameSize;
 
-    buffer = malloc(fileSize);
+    buffer = pool_acquire(fileSize);
     if (buffer == NULL) {
         perror("Error allocating memory");
         exit(1);
@@ -30,29 +60,26 @@ void reverse(FILE *inputFile, FILE *outputFile,
     size_t bytesRead = fread(buffer, 1, fileSize, inputFile);
     if (bytesRead != fileSize) {
         perror("Error reading file data");
-        free(buffer);
+        pool_release(buffer);
         exit(1);
     }
 
     // Reverse the frames in the buffer
     for (int64_t start = 0, end = fileSize - frameSize; start < end;
             start += frameSize, end -= frameSize) {
-        unsigned char temp[frameSize];
-        memcpy(temp, &buffer[start], frameSize);
-        memcpy(&buffer[start], &buffer[end], frameSize);
-        memcpy(&buffer[end], temp, frameSize);
+        swap_planes(&buffer[start], &buffer[end], frameSize);
     }
 
     // Write the reversed data to the output file
     size_t bytesWritten = fwrite(buffer, 1, fileSize, outputFile);
     if (bytesWritten != fileSize) {
         perror("Error writing file data");
-        free(buffer);
+        pool_release(buffer);
         exit(1);
     }
 
     printf("Successfully wrote %zu bytes to output file.\n", bytesWritten);
-    free(buffer);
+    pool_release(buffer);
 }
 
 void reverse_fast(FILE *inputFile, FILE *outputFile,
@@ -63,16 +90,16 @@ void reverse_fast(FILE *inputFile, FILE *outputFile,
 
     // Memory map the input file
     int inputFd = fileno(inputFile);
-    if (inputFd == -1) {
-        perror("Error getting file descriptor for input file");
-        exit(EXIT_FAILURE);
-    }
-
-    unsigned char *mappedData = mmap(NULL, fileSize + 11,
+    unsigned char *mappedData = MAP_FAILED;
+    if (inputFd != -1) {
+        mappedData = mmap(NULL, fileSize + 11,
             PROT_READ, MAP_PRIVATE, inputFd, 0);
+    }
     if (mappedData == MAP_FAILED) {
-        perror("Error mapping input file");
-        exit(EXIT_FAILURE);
+        // Decoded or otherwise unmappable input, read frame by frame
+        reverse_small(inputFile, outputFile, numFrames, height,
+            width, channels);
+        return;
     }
 
     // Skip metadata
@@ -81,7 +108,7 @@ void reverse_fast(FILE *inputFile, FILE *outputFile,
     size_t batchSize = 1024;  // Number of frames per batch
 
     // No mapping for output file
-    unsigned char *writeBuffer = malloc(batchSize * frameSize);
+    unsigned char *writeBuffer = pool_acquire(batchSize * frameSize);
     if (writeBuffer == NULL) {
         perror("Error allocating write buffer");
         munmap(mappedData, fileSize + 11);
@@ -103,7 +130,7 @@ void reverse_fast(FILE *inputFile, FILE *outputFile,
         fwrite(writeBuffer, 1, (batchStart - batchEnd + 1) * frameSize,
             outputFile);
     }
-    free(writeBuffer);
+    pool_release(writeBuffer);
     munmap(mappedData, fileSize + 11);
 }
 
@@ -111,7 +138,7 @@ void reverse_small(FILE *inputFile, FILE *outputFile,
         int64_t numFrames, unsigned char height,
         unsigned char width, unsigned char channels) {
     size_t frameSize = height * width * channels;
-    unsigned char *buffer = malloc(frameSize);
+    unsigned char *buffer = pool_acquire(frameSize);
 
     if (buffer == NULL) {
         perror("Error allocating memory");
@@ -125,17 +152,17 @@ void reverse_small(FILE *inputFile, FILE *outputFile,
         size_t bytesRead = fread(buffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(buffer);
+            pool_release(buffer);
             exit(1);
         }
         // Writes one frame to output file
         if (fwrite(buffer, 1, frameSize, outputFile) != frameSize) {
             perror("Error writing frame data");
-            free(buffer);
+            pool_release(buffer);
             exit(1);
         }
     }
-    free(buffer);
+    pool_release(buffer);
     printf("Reverse operation completed successfully.\n");
 }
 
@@ -153,7 +180,7 @@ void swap_channel(FILE *inputFile, FILE *outputFile, unsigned char ch1,
     size_t totalSize = numFramesBatch * frameSize;
 
     // Buffer for reading/writing frames
-    unsigned char *buffer = malloc(totalSize);
+    unsigned char *buffer = pool_acquire(totalSize);
     if (!buffer) {
         perror("Memory allocation failed");
         exit(1);
@@ -172,7 +199,7 @@ void swap_channel(FILE *inputFile, FILE *outputFile, unsigned char ch1,
         size_t bytesRead = fread(buffer, 1, totalSize, inputFile);
         if (bytesRead != totalSize) {
             perror("Error reading input file");
-            free(buffer);
+            pool_release(buffer);
             exit(1);
         }
 
@@ -184,23 +211,19 @@ void swap_channel(FILE *inputFile, FILE *outputFile, unsigned char ch1,
             unsigned char *ch1_start = frameStart + (ch1 * height * width);
             unsigned char *ch2_start = frameStart + (ch2 * height * width);
 
-            for (size_t pixel = 0; pixel < height * width; pixel++) {
-                unsigned char temp = ch1_start[pixel];
-                ch1_start[pixel] = ch2_start[pixel];
-                ch2_start[pixel] = temp;
-            }
+            swap_planes(ch1_start, ch2_start, height * width);
         }
         // Write the modified batch back to the output file
         size_t bytesWritten = fwrite(buffer, 1, totalSize, outputFile);
         if (bytesWritten != totalSize) {
             perror("Error writing to output file");
-            free(buffer);
+            pool_release(buffer);
             exit(1);
         }
 
         framesProcessed += numFramesBatch;
     }
-    free(buffer);
+    pool_release(buffer);
     printf("Channel swapping completed successfully.\n");
 }
 
@@ -217,26 +240,16 @@ void swap_channel_fast(FILE *inputFile, FILE *outputFile, unsigned char ch1,
     size_t totalSize = numFrames * frameSize;
 
     // Buffer for reading/writing frames
-    unsigned char *buffer = malloc(totalSize);
+    unsigned char *buffer = pool_acquire(totalSize);
     if (!buffer) {
         perror("Memory allocation failed");
         exit(1);
     }
-    // Temporary buffer for swapping channels
-    unsigned char *tempBuffer = malloc(channelSize);
-    if (!buffer || !tempBuffer) {
-        perror("Memory allocation failed");
-        free(buffer);
-        free(tempBuffer);
-        exit(1);
-    }
-
     // Read the entire file into memory
     size_t bytesRead = fread(buffer, 1, totalSize, inputFile);
     if (bytesRead != totalSize) {
         perror("Error reading input file");
-        free(buffer);
-        free(tempBuffer);
+        pool_release(buffer);
         exit(1);
     }
 
@@ -246,25 +259,21 @@ void swap_channel_fast(FILE *inputFile, FILE *outputFile, unsigned char ch1,
         unsigned char *ch1_start = frameStart + (ch1 * channelSize);
         unsigned char *ch2_start = frameStart + (ch2 * channelSize);
 
-        // Swap using memcpy - faster than a loop
-        memcpy(tempBuffer, ch1_start, channelSize);
-        memcpy(ch1_start, ch2_start, channelSize);
-        memcpy(ch2_start, tempBuffer, channelSize);
+        // Swap in one pass, no temporary plane needed
+        swap_planes(ch1_start, ch2_start, channelSize);
     }
 
     // Write the modified data back to the output file
     size_t bytesWritten = fwrite(buffer, 1, totalSize, outputFile);
     if (bytesWritten != totalSize) {
         perror("Error writing to output file");
-        free(buffer);
-        free(tempBuffer);
+        pool_release(buffer);
         exit(1);
     }
 
-    free(buffer);
-    free(tempBuffer);
+    pool_release(buffer);
 
-    printf("Channel swapping completed successfully using memcpy.\n");
+    printf("Channel swapping completed successfully.\n");
 }
 
 void swap_channel_small(FILE *inputFile, FILE *outputFile, unsigned char ch1,
@@ -279,7 +288,7 @@ void swap_channel_small(FILE *inputFile, FILE *outputFile, unsigned char ch1,
     size_t channelSize = height * width;
 
     // Allocate memory for reading/writing frames
-    unsigned char *frameBuffer = malloc(frameSize);
+    unsigned char *frameBuffer = pool_acquire(frameSize);
     if (!frameBuffer) {
         perror("Memory allocation failed");
         exit(1);
@@ -290,29 +299,25 @@ void swap_channel_small(FILE *inputFile, FILE *outputFile, unsigned char ch1,
         size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
 
         unsigned char *ch1_start = frameBuffer + (ch1 * channelSize);
         unsigned char *ch2_start = frameBuffer + (ch2 * channelSize);
 
-        // Swap the channels using a temporary buffer
-        for (size_t pixel = 0; pixel < channelSize; pixel++) {
-            unsigned char temp = ch1_start[pixel];
-            ch1_start[pixel] = ch2_start[pixel];
-            ch2_start[pixel] = temp;
-        }
+        // Swap the channels in place
+        swap_planes(ch1_start, ch2_start, channelSize);
 
         // Write the modified frame to the output file
         size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
         if (bytesWritten != frameSize) {
             perror("Error writing frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
     }
-    free(frameBuffer);
+    pool_release(frameBuffer);
 }
 
 
@@ -327,7 +332,7 @@ void clip_channel(FILE *inputFile, FILE *outputFile, unsigned char channel,
     size_t frameSize = height * width * channels;
     size_t channelSize = height * width;
 
-    unsigned char *frameBuffer = malloc(frameSize);
+    unsigned char *frameBuffer = pool_acquire(frameSize);
     if (frameBuffer == NULL) {
         perror("Error allocating memory");
         exit(1);
@@ -338,31 +343,23 @@ void clip_channel(FILE *inputFile, FILE *outputFile, unsigned char channel,
         size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
 
         // Clips each pixel in the channel
-        for (size_t pixel = 0; pixel < channelSize; pixel++) {
-            unsigned char *channelValue =
-                &frameBuffer[channel * channelSize + pixel];
-            if (*channelValue > max) {
-                *channelValue = max;
-            } else if (*channelValue < min) {
-                *channelValue = min;
-            }
-        }
+        clip_plane(frameBuffer + channel * channelSize, channelSize, min, max);
 
         // Write the modified frame to the output file
         size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
         if (bytesWritten != frameSize) {
             perror("Error writing frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
     }
 
-    free(frameBuffer);
+    pool_release(frameBuffer);
 }
 
 void clip_channel_fast(FILE *inputFile, FILE *outputFile, unsigned char channel,
@@ -377,60 +374,39 @@ void clip_channel_fast(FILE *inputFile, FILE *outputFile, unsigned char channel,
     size_t channelSize = height * width;
 
     // Allocate memory for the frame buffer
-    unsigned char *frameBuffer = malloc(frameSize);
+    unsigned char *frameBuffer = pool_acquire(frameSize);
     if (frameBuffer == NULL) {
         perror("Error allocating memory");
         exit(EXIT_FAILURE);
     }
 
-    // Create a dynamic lookup table for pixel values
-    unsigned char lookupTable[256];
-    // Track which values have been processed
-    bool isValueProcessed[256] = {false};
-
     // Process each frame
     for (int64_t frame = 0; frame < numFrames; frame++) {
         // Read the frame from the input file
         size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(EXIT_FAILURE);
         }
 
         // Get the pointer to the start of the specified channel
         unsigned char *channelStart = frameBuffer + channel * channelSize;
 
-        // Apply dynamic lookup table to the channel
-        for (int64_t pixel = 0; pixel < channelSize; pixel++) {
-            unsigned char pixelValue = channelStart[pixel];
-            if (!isValueProcessed[pixelValue]) {
-                // Compute and store the clamped value in the lookup table
-                if (pixelValue < min) {
-                    lookupTable[pixelValue] = min;
-                } else if (pixelValue > max) {
-                    lookupTable[pixelValue] = max;
-                } else {
-                    lookupTable[pixelValue] = pixelValue;
-                }
-                isValueProcessed[pixelValue] = true;
-            }
-
-            // Replace the pixel value with its clamped counterpart
-            channelStart[pixel] = lookupTable[pixelValue];
-        }
+        // Vector min/max clamps a whole register of pixels at once
+        clip_plane(channelStart, channelSize, min, max);
 
         // Write the modified frame to the output file
         size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
         if (bytesWritten != frameSize) {
             perror("Error writing frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(EXIT_FAILURE);
         }
     }
     // Clean up
-    free(frameBuffer);
-    printf("Clipping operation completed successfully with dynamic lookup.\n");
+    pool_release(frameBuffer);
+    printf("Clipping operation completed successfully.\n");
 }
 
 void clip_channel_small(FILE *inputFile, FILE *outputFile,
@@ -446,7 +422,7 @@ void clip_channel_small(FILE *inputFile, FILE *outputFile,
     size_t channelSize = height * width;
 
     // Allocate memory for the frame buffer
-    unsigned char *frameBuffer = malloc(frameSize);
+    unsigned char *frameBuffer = pool_acquire(frameSize);
     if (frameBuffer == NULL) {
         perror("Error allocating memory");
         exit(1);
@@ -457,29 +433,21 @@ void clip_channel_small(FILE *inputFile, FILE *outputFile,
         size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
-        for (size_t pixel = 0; pixel < channelSize; pixel++) {
-            unsigned char *channelValue =
-                &frameBuffer[channel * channelSize + pixel];
-            // Clamp the pixel value
-            if (*channelValue > max) {
-                *channelValue = max;
-            } else if (*channelValue < min) {
-                *channelValue = min;
-            }
-        }
+        // Clamp the pixel values
+        clip_plane(frameBuffer + channel * channelSize, channelSize, min, max);
         // Write the modified frame to the output file
         size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
         if (bytesWritten != frameSize) {
             perror("Error writing frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
     }
     // Clean up
-    free(frameBuffer);
+    pool_release(frameBuffer);
 }
 
 
@@ -495,7 +463,7 @@ void scale_channel(FILE *inputFile, FILE *outputFile, unsigned char channel,
     size_t channelSize = height * width;
 
     // Allocate memory for the frame buffer
-    unsigned char *frameBuffer = malloc(frameSize);
+    unsigned char *frameBuffer = pool_acquire(frameSize);
     if (frameBuffer == NULL) {
         perror("Error allocating memory");
         exit(1);
@@ -505,36 +473,25 @@ void scale_channel(FILE *inputFile, FILE *outputFile, unsigned char channel,
         size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
         // Get the pointer to the start of the specified channel
         unsigned char *channelStart = frameBuffer + channel * channelSize;
 
-        #pragma omp parallel for
-
-        // Apply the scaling factor to each pixel in the channel
-        for (int64_t pixel = 0; pixel < channelSize; pixel++) {
-            float scaledValue = channelStart[pixel] * factor;
-            // Clamp the scaled value to the range [0, 255]
-            if (scaledValue > 255) {
-                channelStart[pixel] = 255;
-            } else if (scaledValue < 0) {
-                channelStart[pixel] = 0;
-            } else {
-                channelStart[pixel] = (unsigned char)scaledValue;
-            }
-        }
+        // Apply the scaling factor to each pixel in the channel, clamped
+        // to the range [0, 255]
+        scale_plane(channelStart, channelSize, factor);
         // Write the modified frame to the output file
         size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
         if (bytesWritten != frameSize) {
             perror("Error writing frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
     }
 
-    free(frameBuffer);
+    pool_release(frameBuffer);
 }
 
 void scale_channel_fast(FILE *inputFile, FILE *outputFile,
@@ -549,49 +506,33 @@ void scale_channel_fast(FILE *inputFile, FILE *outputFile,
     size_t channelSize = height * width;
 
     // Allocate memory for the frame buffer
-    unsigned char *frameBuffer = malloc(frameSize);
+    unsigned char *frameBuffer = pool_acquire(frameSize);
     if (frameBuffer == NULL) {
         perror("Error allocating memory");
         exit(1);
     }
 
-    // Create an empty lookup table for pixel values
-    unsigned char lookup_table[256];
-    bool table_initialized[256] = { false };
-
     for (int64_t frame = 0; frame < numFrames; frame++) {
         size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
 
         unsigned char *channelStart = frameBuffer + channel * channelSize;
-        for (size_t pixel = 0; pixel < channelSize; pixel++) {
-            unsigned char value = channelStart[pixel];
-
-            // Add pixel to table if not already present
-            if (!table_initialized[value]) {
-                float scaled = value * factor;
-                if (scaled > 255) scaled = 255;
-                else if (scaled < 0) scaled = 0;
-                lookup_table[value] = (unsigned char)scaled;
-                table_initialized[value] = true;
-            }
-            // Replace pixel value with scaled value from table
-            channelStart[pixel] = lookup_table[value];
-        }
+        // Vector multiply and clamp, no per-pixel table lookups
+        scale_plane(channelStart, channelSize, factor);
         // Write the modified frame to the output file
         size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
         if (bytesWritten != frameSize) {
             perror("Error writing frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
     }
     // Clean up
-    free(frameBuffer);
+    pool_release(frameBuffer);
 }
 
 void scale_channel_small(FILE *inputFile, FILE *outputFile,
@@ -605,14 +546,14 @@ void scale_channel_small(FILE *inputFile, FILE *outputFile,
     size_t channelSize = height * width;
     size_t frameSize = channelSize * channels;
     // Buffer for a single channel
-    unsigned char *channelBuffer = malloc(channelSize);
+    unsigned char *channelBuffer = pool_acquire(channelSize);
     // Buffer for a single frame
-    unsigned char *frameBuffer = malloc(frameSize);
+    unsigned char *frameBuffer = pool_acquire(frameSize);
 
     if (channelBuffer == NULL || frameBuffer == NULL) {
         perror("Error allocating memory");
-        free(channelBuffer);
-        free(frameBuffer);
+        pool_release(channelBuffer);
+        pool_release(frameBuffer);
         exit(1);
     }
 
@@ -620,8 +561,8 @@ void scale_channel_small(FILE *inputFile, FILE *outputFile,
         size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(channelBuffer);
-            free(frameBuffer);
+            pool_release(channelBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
         // Get the pointer to the start of the specified channel
@@ -629,16 +570,7 @@ void scale_channel_small(FILE *inputFile, FILE *outputFile,
         memcpy(channelBuffer, frameBuffer + channelOffset, channelSize);
 
         // Apply the scaling factor to each pixel in the channel
-        for (size_t pixel = 0; pixel < channelSize; pixel++) {
-            float scaledValue = channelBuffer[pixel] * factor;
-            if (scaledValue > 255) {
-                channelBuffer[pixel] = 255;
-            } else if (scaledValue < 0) {
-                channelBuffer[pixel] = 0;
-            } else {
-                channelBuffer[pixel] = (unsigned char)scaledValue;
-            }
-        }
+        scale_plane(channelBuffer, channelSize, factor);
         // Copy the modified channel back to the frame buffer
         memcpy(frameBuffer + channelOffset, channelBuffer, channelSize);
 
@@ -646,12 +578,12 @@ void scale_channel_small(FILE *inputFile, FILE *outputFile,
         size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
         if (bytesWritten != frameSize) {
             perror("Error writing frame data");
-            free(channelBuffer);
-            free(frameBuffer);
+            pool_release(channelBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
     }
     // Clean up
-    free(channelBuffer);
-    free(frameBuffer);
+    pool_release(channelBuffer);
+    pool_release(frameBuffer);
 }
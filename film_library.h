@@ -2,16 +2,34 @@
 #ifndef LIB_FILMMASTER2000_H
 #define LIB_FILMMASTER2000_H
 #include <stdio.h>
+#include <stdint.h>
 
 #pragma pack(1)  // Disable padding
 typedef struct {
-    int64_t numFrames;
+    int64_t numFrames : 56;
+    unsigned char format;  // Colour space and subsampling, 0 for planar RGB
     unsigned char channels;
     unsigned char height;
     unsigned char width;
 } VideoMetadata;
 #pragma pack()
 
+// Format byte, stored in the top byte of the original 64-bit frame count
+// so existing files read as RGB 4:4:4
+#define FORMAT_COLOUR_MASK 0x03
+#define FORMAT_RGB 0x00
+#define FORMAT_YUV_BT601 0x01
+#define FORMAT_YUV_BT709 0x02
+#define FORMAT_CHROMA_MASK 0x0c
+#define FORMAT_CHROMA_444 0x00
+#define FORMAT_CHROMA_420 0x04
+#define FORMAT_PACKED 0x10  // pixels interleaved, 4:4:4 only
+#define FORMAT_COMPRESSED 0x80
+
+size_t frame_size(const VideoMetadata *metadata);
+void update_metadata(FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width);
+
 void reverse(FILE *inputFile, FILE *outputFile,
     int64_t numFrames, unsigned char height,
     unsigned char width, unsigned char channels);
@@ -0,0 +1,156 @@
+// Copyright 2025 Rose Laird
+
+#include <stdlib.h>  // for calloc, free
+#include <string.h>  // for memcpy
+#include <omp.h>  // for OpenMP parallelization
+#include "film_library.h"  // for VideoMetadata and frame_size
+#include "film_library_simd.h"  // for the dispatched pixel kernels
+#include "film_library_stats.h"  // for channel_histogram
+#include "film_library_api.h"
+
+int32_t fm_abi_version(void) {
+    return FM_ABI_VERSION;
+}
+
+int32_t fm_read_header(const unsigned char *data, size_t size,
+        FmVideoInfo *info) {
+    VideoMetadata metadata;
+    if (size < sizeof(VideoMetadata)) return -1;
+    memcpy(&metadata, data, sizeof(VideoMetadata));
+    info->numFrames = metadata.numFrames;
+    info->format = metadata.format;
+    info->channels = metadata.channels;
+    info->height = metadata.height;
+    info->width = metadata.width;
+    info->frameSize = frame_size(&metadata);
+    info->dataOffset = sizeof(VideoMetadata);
+    return 0;
+}
+
+// Channel planes are only all the same size without chroma subsampling
+static int full_resolution(const FmVideoInfo *info) {
+    return (info->format & (FORMAT_CHROMA_MASK | FORMAT_COMPRESSED)) == 0;
+}
+
+static int packed(const FmVideoInfo *info) {
+    return (info->format & FORMAT_PACKED) != 0;
+}
+
+static int valid_channel(const FmVideoInfo *info, int32_t channel) {
+    return channel >= 0 && channel < info->channels;
+}
+
+int32_t fm_clip_channel(unsigned char *frames, int64_t numFrames,
+        const FmVideoInfo *info, int32_t channel, int32_t min, int32_t max) {
+    if (!full_resolution(info) || !valid_channel(info, channel)
+            || min < 0 || max > 255 || min > max) {
+        return -1;
+    }
+    size_t planeSize = (size_t)info->height * info->width;
+    if (packed(info)) {
+        #pragma omp parallel for
+        for (int64_t frame = 0; frame < numFrames; frame++) {
+            clip_packed(frames + frame * info->frameSize, planeSize,
+                        info->channels, channel, min, max);
+        }
+        return 0;
+    }
+    #pragma omp parallel for
+    for (int64_t frame = 0; frame < numFrames; frame++) {
+        clip_plane(frames + frame * info->frameSize + channel * planeSize,
+                   planeSize, min, max);
+    }
+    return 0;
+}
+
+int32_t fm_scale_channel(unsigned char *frames, int64_t numFrames,
+        const FmVideoInfo *info, int32_t channel, float factor) {
+    if (!full_resolution(info) || !valid_channel(info, channel)) return -1;
+    size_t planeSize = (size_t)info->height * info->width;
+    if (packed(info)) {
+        #pragma omp parallel for
+        for (int64_t frame = 0; frame < numFrames; frame++) {
+            scale_packed(frames + frame * info->frameSize, planeSize,
+                         info->channels, channel, factor);
+        }
+        return 0;
+    }
+    #pragma omp parallel for
+    for (int64_t frame = 0; frame < numFrames; frame++) {
+        scale_plane(frames + frame * info->frameSize + channel * planeSize,
+                    planeSize, factor);
+    }
+    return 0;
+}
+
+int32_t fm_swap_channels(unsigned char *frames, int64_t numFrames,
+        const FmVideoInfo *info, int32_t channel1, int32_t channel2) {
+    if (!full_resolution(info) || !valid_channel(info, channel1)
+            || !valid_channel(info, channel2)) {
+        return -1;
+    }
+    if (channel1 == channel2) return 0;
+    size_t planeSize = (size_t)info->height * info->width;
+    if (packed(info)) {
+        #pragma omp parallel for
+        for (int64_t frame = 0; frame < numFrames; frame++) {
+            swap_packed(frames + frame * info->frameSize, planeSize,
+                        info->channels, channel1, channel2);
+        }
+        return 0;
+    }
+    #pragma omp parallel for
+    for (int64_t frame = 0; frame < numFrames; frame++) {
+        unsigned char *frameData = frames + frame * info->frameSize;
+        swap_planes(frameData + channel1 * planeSize,
+                    frameData + channel2 * planeSize, planeSize);
+    }
+    return 0;
+}
+
+int32_t fm_histogram(const unsigned char *frames, int64_t numFrames,
+        const FmVideoInfo *info, uint64_t *histograms) {
+    if (!full_resolution(info) || packed(info)) return -1;
+    size_t planeSize = (size_t)info->height * info->width;
+    int failed = 0;
+
+    #pragma omp parallel reduction(|:failed)
+    {
+        // Per-thread totals, merged once at the end
+        uint64_t *local = calloc(info->channels * 256, sizeof(uint64_t));
+        uint32_t planeHistogram[256];
+        if (!local) failed = 1;
+        #pragma omp for
+        for (int64_t frame = 0; frame < numFrames; frame++) {
+            if (!local) continue;
+            for (int32_t channel = 0; channel < info->channels; channel++) {
+                channel_histogram(frames + frame * info->frameSize
+                                  + channel * planeSize, planeSize,
+                                  planeHistogram);
+                for (int value = 0; value < 256; value++) {
+                    local[channel * 256 + value] += planeHistogram[value];
+                }
+            }
+        }
+        if (local) {
+            #pragma omp critical
+            for (int32_t i = 0; i < info->channels * 256; i++) {
+                histograms[i] += local[i];
+            }
+        }
+        free(local);
+    }
+    return failed ? -1 : 0;
+}
+
+int32_t fm_interleave(const unsigned char *frame, unsigned char *pixels,
+        const FmVideoInfo *info) {
+    if (!full_resolution(info)) return -1;
+    if (packed(info)) {
+        memcpy(pixels, frame, info->frameSize);
+        return 0;
+    }
+    size_t planeSize = (size_t)info->height * info->width;
+    pack_planes(frame, planeSize, info->channels, pixels);
+    return 0;
+}
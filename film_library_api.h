@@ -0,0 +1,48 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_API_H
+#define LIB_FILMMASTER2000_API_H
+#include <stddef.h>
+#include <stdint.h>
+
+// Stable C interface of libFilmMaster2000.so for other languages. Every
+// function works in place on memory the caller owns (a mapped file, a
+// NumPy array...), takes only fixed width types and returns 0 on success
+// or -1 for arguments it cannot handle. Bump FM_ABI_VERSION whenever a
+// signature or FmVideoInfo changes.
+#define FM_ABI_VERSION 1
+
+// The library is built with -fvisibility=hidden, only these are exported
+#define FM_API __attribute__((visibility("default")))
+
+typedef struct {
+    int64_t numFrames;
+    int32_t format;  // FORMAT_* bits of the header
+    int32_t channels;
+    int32_t height;
+    int32_t width;
+    int64_t frameSize;  // bytes per frame, chroma subsampling included
+    int64_t dataOffset;  // bytes before the first frame
+} FmVideoInfo;
+
+FM_API int32_t fm_abi_version(void);
+// Reads the header at the start of data, which holds size bytes
+FM_API int32_t fm_read_header(const unsigned char *data, size_t size,
+    FmVideoInfo *info);
+
+// Per-channel operations on numFrames consecutive frames, parallel across
+// frames. Channels must be full resolution (4:4:4), planar or packed.
+FM_API int32_t fm_clip_channel(unsigned char *frames, int64_t numFrames,
+    const FmVideoInfo *info, int32_t channel, int32_t min, int32_t max);
+FM_API int32_t fm_scale_channel(unsigned char *frames, int64_t numFrames,
+    const FmVideoInfo *info, int32_t channel, float factor);
+FM_API int32_t fm_swap_channels(unsigned char *frames, int64_t numFrames,
+    const FmVideoInfo *info, int32_t channel1, int32_t channel2);
+// Adds the frames' pixel counts to histograms, 256 entries per channel,
+// planar frames only
+FM_API int32_t fm_histogram(const unsigned char *frames, int64_t numFrames,
+    const FmVideoInfo *info, uint64_t *histograms);
+// Converts one planar frame to height x width x channels order, as image
+// libraries expect, packed frames are copied as they are
+FM_API int32_t fm_interleave(const unsigned char *frame, unsigned char *pixels,
+    const FmVideoInfo *info);
+#endif
@@ -0,0 +1,625 @@
+// Copyright 2025 Rose Laird
+
+#define _GNU_SOURCE  // for fopencookie
+#include <stdio.h>
+#include <stdlib.h>  // for malloc, free, exit
+#include <string.h>  // for memcpy, memset
+#include <omp.h>  // for OpenMP parallelization
+#include <unistd.h>  // for pread
+#include <immintrin.h>  // for AVX2 intrinsics SIMD
+#include <stdint.h>  // for int64_t type
+#include <stdbool.h>  // for boolean type
+#include "film_library.h"  // for VideoMetadata and frame_size
+#include "film_library_simd.h"  // for simd_level
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_codec.h"
+
+// Container layout after the 11-byte header (format has FORMAT_COMPRESSED):
+//   [gop size (uint32)]
+//   per frame: [payload size (uint32)][run-length coded payload]
+//   [offset of each GOP from the start of the file (uint64 each)]
+//   [offset of that index (uint64)]
+// The first frame of every GOP is coded as is, the rest as the byte-wise
+// difference from the previous frame, so static content becomes zero runs.
+
+// Run-length codes:
+//   0x00-0x7f  (c + 1) literal bytes follow
+//   0x80-0xfe  next byte repeated (c - 0x80 + 3) times
+//   0xff       uint16 count then the byte to repeat
+#define RLE_MAX_LITERAL 128
+#define RLE_MIN_RUN 3
+#define RLE_MAX_SHORT_RUN (0xfe - 0x80 + RLE_MIN_RUN)
+#define RLE_MAX_LONG_RUN 65535
+
+size_t compressed_bound(size_t size) {
+    return size + size / RLE_MAX_LITERAL + 16;
+}
+
+TARGET_AVX2
+static size_t run_length_avx2(const unsigned char *src, size_t limit) {
+    size_t length = 1;
+    __m256i value = _mm256_set1_epi8((char)src[0]);
+    while (length + 32 <= limit) {
+        uint32_t equal = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(src + length)), value));
+        if (equal != 0xffffffffu) {
+            return length + __builtin_ctz(~equal);
+        }
+        length += 32;
+    }
+    return length;
+}
+
+// Number of bytes equal to src[0], up to limit
+static size_t run_length(const unsigned char *src, size_t limit) {
+    size_t length = 1;
+    if (simd_level() >= SIMD_AVX2) length = run_length_avx2(src, limit);
+    while (length < limit && src[length] == src[0]) {
+        length++;
+    }
+    return length;
+}
+
+static size_t rle_flush_literals(const unsigned char *src, size_t count,
+        unsigned char *dst) {
+    size_t written = 0;
+    while (count > 0) {
+        size_t chunk = count < RLE_MAX_LITERAL ? count : RLE_MAX_LITERAL;
+        dst[written++] = (unsigned char)(chunk - 1);
+        memcpy(dst + written, src, chunk);
+        written += chunk;
+        src += chunk;
+        count -= chunk;
+    }
+    return written;
+}
+
+size_t rle_encode(const unsigned char *src, size_t size, unsigned char *dst) {
+    size_t in = 0, out = 0, literalStart = 0;
+    while (in < size) {
+        // Cheap scalar check before looking for a long run
+        if (in + RLE_MIN_RUN > size || src[in + 1] != src[in]
+                || src[in + 2] != src[in]) {
+            in++;
+            continue;
+        }
+        size_t limit = size - in < RLE_MAX_LONG_RUN ? size - in
+                                                    : RLE_MAX_LONG_RUN;
+        size_t run = run_length(src + in, limit);
+
+        out += rle_flush_literals(src + literalStart, in - literalStart,
+                                  dst + out);
+        if (run <= RLE_MAX_SHORT_RUN) {
+            dst[out++] = (unsigned char)(0x80 + run - RLE_MIN_RUN);
+        } else {
+            dst[out++] = 0xff;
+            dst[out++] = (unsigned char)(run & 0xff);
+            dst[out++] = (unsigned char)(run >> 8);
+        }
+        dst[out++] = src[in];
+        in += run;
+        literalStart = in;
+    }
+    out += rle_flush_literals(src + literalStart, in - literalStart,
+                              dst + out);
+    return out;
+}
+
+int rle_decode(const unsigned char *src, size_t size, unsigned char *dst,
+        size_t dstSize) {
+    size_t in = 0, out = 0;
+    while (in < size) {
+        unsigned char code = src[in++];
+        size_t count;
+        if (code < 0x80) {
+            count = code + 1;
+            if (in + count > size || out + count > dstSize) return -1;
+            memcpy(dst + out, src + in, count);
+            in += count;
+        } else {
+            if (code == 0xff) {
+                if (in + 2 > size) return -1;
+                count = src[in] | (src[in + 1] << 8);
+                in += 2;
+            } else {
+                count = code - 0x80 + RLE_MIN_RUN;
+            }
+            if (in >= size || out + count > dstSize) return -1;
+            memset(dst + out, src[in++], count);
+        }
+        out += count;
+    }
+    return out == dstSize ? 0 : -1;
+}
+
+TARGET_AVX2
+static size_t frame_delta_avx2(const unsigned char *a, const unsigned char *b,
+        unsigned char *out, size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_sub_epi8(
+            _mm256_loadu_si256((const __m256i *)(a + i)),
+            _mm256_loadu_si256((const __m256i *)(b + i))));
+    }
+    return i;
+}
+
+// out = a - b byte-wise (mod 256)
+static void frame_delta(const unsigned char *a, const unsigned char *b,
+        unsigned char *out, size_t size) {
+    size_t i = 0;
+    if (simd_level() >= SIMD_AVX2) i = frame_delta_avx2(a, b, out, size);
+    for (; i < size; i++) {
+        out[i] = (unsigned char)(a[i] - b[i]);
+    }
+}
+
+TARGET_AVX2
+static size_t frame_undelta_avx2(unsigned char *frame,
+        const unsigned char *previous, size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        _mm256_storeu_si256((__m256i *)(frame + i), _mm256_add_epi8(
+            _mm256_loadu_si256((const __m256i *)(frame + i)),
+            _mm256_loadu_si256((const __m256i *)(previous + i))));
+    }
+    return i;
+}
+
+// frame += previous byte-wise (mod 256)
+static void frame_undelta(unsigned char *frame, const unsigned char *previous,
+        size_t size) {
+    size_t i = 0;
+    if (simd_level() >= SIMD_AVX2) {
+        i = frame_undelta_avx2(frame, previous, size);
+    }
+    for (; i < size; i++) {
+        frame[i] = (unsigned char)(frame[i] + previous[i]);
+    }
+}
+
+// Encode one GOP into out, returning the number of bytes written
+static size_t encode_gop(const unsigned char *frames, int64_t count,
+        size_t frameSize, unsigned char *delta, unsigned char *out) {
+    size_t written = 0;
+    for (int64_t frame = 0; frame < count; frame++) {
+        const unsigned char *source = frames + frame * frameSize;
+        if (frame > 0) {
+            frame_delta(source, source - frameSize, delta, frameSize);
+            source = delta;
+        }
+        uint32_t payloadSize = (uint32_t)rle_encode(source, frameSize,
+                                                    out + written + 4);
+        memcpy(out + written, &payloadSize, 4);
+        written += 4 + payloadSize;
+    }
+    return written;
+}
+
+// Decode count frames of one GOP from a buffer holding the whole GOP
+static int decode_gop(const unsigned char *src, size_t size, int64_t count,
+        size_t frameSize, unsigned char *frames) {
+    size_t offset = 0;
+    for (int64_t frame = 0; frame < count; frame++) {
+        uint32_t payloadSize;
+        if (offset + 4 > size) return -1;
+        memcpy(&payloadSize, src + offset, 4);
+        offset += 4;
+        if (offset + payloadSize > size) return -1;
+
+        unsigned char *out = frames + frame * frameSize;
+        if (rle_decode(src + offset, payloadSize, out, frameSize) != 0) {
+            return -1;
+        }
+        if (frame > 0) {
+            frame_undelta(out, out - frameSize, frameSize);
+        }
+        offset += payloadSize;
+    }
+    return 0;
+}
+
+void compress_video(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *inputMetadata, int gopSize) {
+    if (gopSize < 1) {
+        fprintf(stderr, "Error: GOP size must be at least 1.\n");
+        exit(1);
+    }
+
+    VideoMetadata metadata = *inputMetadata;
+    metadata.format |= FORMAT_COMPRESSED;
+    int64_t numFrames = metadata.numFrames;
+    size_t frameSize = frame_size(&metadata);
+    int64_t numGops = (numFrames + gopSize - 1) / gopSize;
+    // Encode one GOP per thread at a time
+    int gopsPerBatch = omp_get_max_threads();
+    size_t gopBytes = gopSize * frameSize;
+    size_t encodedGopBytes = gopSize * (4 + compressed_bound(frameSize));
+
+    unsigned char *frames = pool_acquire(gopsPerBatch * gopBytes);
+    unsigned char *encoded = pool_acquire(gopsPerBatch * encodedGopBytes);
+    unsigned char *deltas = pool_acquire(gopsPerBatch * frameSize);
+    size_t *encodedSizes = malloc(gopsPerBatch * sizeof(size_t));
+    uint64_t *gopOffsets = malloc((numGops + 1) * sizeof(uint64_t));
+    if (!frames || !encoded || !deltas || !encodedSizes || !gopOffsets) {
+        perror("Error allocating memory");
+        pool_release(frames);
+        pool_release(encoded);
+        pool_release(deltas);
+        free(encodedSizes);
+        free(gopOffsets);
+        exit(1);
+    }
+
+    uint32_t storedGopSize = (uint32_t)gopSize;
+    fseek(outputFile, 0, SEEK_SET);
+    if (fwrite(&metadata, sizeof(VideoMetadata), 1, outputFile) != 1
+            || fwrite(&storedGopSize, 4, 1, outputFile) != 1) {
+        perror("Error writing metadata");
+        pool_release(frames);
+        pool_release(encoded);
+        pool_release(deltas);
+        free(encodedSizes);
+        free(gopOffsets);
+        exit(1);
+    }
+    uint64_t offset = sizeof(VideoMetadata) + 4;
+
+    for (int64_t firstGop = 0; firstGop < numGops;
+            firstGop += gopsPerBatch) {
+        int64_t gopsInBatch = numGops - firstGop;
+        if (gopsInBatch > gopsPerBatch) gopsInBatch = gopsPerBatch;
+        int64_t firstFrame = firstGop * gopSize;
+        int64_t framesInBatch = numFrames - firstFrame;
+        if (framesInBatch > gopsInBatch * gopSize) {
+            framesInBatch = gopsInBatch * gopSize;
+        }
+
+        if (fread(frames, frameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(frames);
+            pool_release(encoded);
+            pool_release(deltas);
+            free(encodedSizes);
+            free(gopOffsets);
+            exit(1);
+        }
+
+        #pragma omp parallel for schedule(dynamic)
+        for (int64_t gop = 0; gop < gopsInBatch; gop++) {
+            int64_t count = framesInBatch - gop * gopSize;
+            if (count > gopSize) count = gopSize;
+            encodedSizes[gop] = encode_gop(frames + gop * gopBytes, count,
+                frameSize, deltas + omp_get_thread_num() * frameSize,
+                encoded + gop * encodedGopBytes);
+        }
+
+        for (int64_t gop = 0; gop < gopsInBatch; gop++) {
+            gopOffsets[firstGop + gop] = offset;
+            if (fwrite(encoded + gop * encodedGopBytes, 1, encodedSizes[gop],
+                    outputFile) != encodedSizes[gop]) {
+                perror("Error writing compressed data");
+                pool_release(frames);
+                pool_release(encoded);
+                pool_release(deltas);
+                free(encodedSizes);
+                free(gopOffsets);
+                exit(1);
+            }
+            offset += encodedSizes[gop];
+        }
+    }
+
+    // GOP index and trailer so readers can seek and decode in parallel
+    gopOffsets[numGops] = offset;
+    if (fwrite(gopOffsets, sizeof(uint64_t), numGops, outputFile)
+            != (size_t)numGops
+            || fwrite(&offset, sizeof(uint64_t), 1, outputFile) != 1) {
+        perror("Error writing GOP index");
+        pool_release(frames);
+        pool_release(encoded);
+        pool_release(deltas);
+        free(encodedSizes);
+        free(gopOffsets);
+        exit(1);
+    }
+
+    double ratio = offset ? (double)(numFrames * frameSize) / offset : 0;
+    pool_release(frames);
+    pool_release(encoded);
+    pool_release(deltas);
+    free(encodedSizes);
+    free(gopOffsets);
+    printf("Compression completed successfully. Ratio %.2f:1\n", ratio);
+}
+
+// Streaming decoder behind a FILE so every operation reads it unchanged
+#define MAX_WINDOW_BYTES (256 * 1024 * 1024)
+
+typedef struct {
+    FILE *file;
+    VideoMetadata metadata;  // header of the decoded stream
+    size_t frameSize;
+    int64_t gopSize;
+    int64_t numGops;
+    uint64_t *gopOffsets;  // numGops + 1 entries, NULL if not seekable
+    int windowGops;  // GOPs decoded together, one per thread
+    unsigned char *window;  // decoded frames of whole GOPs
+    int64_t windowStart;  // first frame held in window
+    int64_t windowFrames;
+    unsigned char *gopBuffers;  // compressed GOPs, one per thread
+    size_t gopBufferSize;
+    int64_t position;  // read position in the decoded stream
+} CompressedInput;
+
+static int64_t gop_frames(const CompressedInput *input, int64_t gop) {
+    int64_t count = input->metadata.numFrames - gop * input->gopSize;
+    return count < input->gopSize ? count : input->gopSize;
+}
+
+// Decode several GOPs around the one containing frame, in parallel
+static int load_indexed_window(CompressedInput *input, int64_t frame) {
+    int64_t gop = frame / input->gopSize;
+    int64_t firstGop = gop;
+    // Reading backwards (reverse_small), keep the GOPs before this one
+    if (input->windowFrames > 0 && frame < input->windowStart) {
+        firstGop = gop - input->windowGops + 1;
+        if (firstGop < 0) firstGop = 0;
+    }
+    int64_t gopsInWindow = input->numGops - firstGop;
+    if (gopsInWindow > input->windowGops) gopsInWindow = input->windowGops;
+
+    int fd = fileno(input->file);
+    int failed = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+    for (int64_t i = 0; i < gopsInWindow; i++) {
+        int64_t current = firstGop + i;
+        size_t size = input->gopOffsets[current + 1]
+                    - input->gopOffsets[current];
+        unsigned char *buffer = input->gopBuffers
+                              + omp_get_thread_num() * input->gopBufferSize;
+        if (size > input->gopBufferSize
+                || pread(fd, buffer, size, input->gopOffsets[current])
+                   != (ssize_t)size
+                || decode_gop(buffer, size, gop_frames(input, current),
+                       input->frameSize, input->window
+                           + i * input->gopSize * input->frameSize) != 0) {
+            failed = 1;
+        }
+    }
+    if (failed) return -1;
+
+    input->windowStart = firstGop * input->gopSize;
+    input->windowFrames = 0;
+    for (int64_t i = 0; i < gopsInWindow; i++) {
+        input->windowFrames += gop_frames(input, firstGop + i);
+    }
+    return 0;
+}
+
+// Without an index, decode the next GOP from the current file position
+static int load_sequential_window(CompressedInput *input, int64_t frame) {
+    int64_t gop = frame / input->gopSize;
+    if (gop * input->gopSize != input->windowStart + input->windowFrames) {
+        return -1;  // only forward reads are possible on a stream
+    }
+    int64_t count = gop_frames(input, gop);
+    for (int64_t i = 0; i < count; i++) {
+        uint32_t payloadSize;
+        unsigned char *out = input->window + i * input->frameSize;
+        if (fread(&payloadSize, 4, 1, input->file) != 1
+                || payloadSize > input->gopBufferSize
+                || fread(input->gopBuffers, 1, payloadSize, input->file)
+                   != payloadSize
+                || rle_decode(input->gopBuffers, payloadSize, out,
+                              input->frameSize) != 0) {
+            return -1;
+        }
+        if (i > 0) {
+            frame_undelta(out, out - input->frameSize, input->frameSize);
+        }
+    }
+    input->windowStart = gop * input->gopSize;
+    input->windowFrames = count;
+    return 0;
+}
+
+static ssize_t compressed_read(void *cookie, char *buf, size_t size) {
+    CompressedInput *input = cookie;
+    int64_t streamSize = sizeof(VideoMetadata)
+                       + input->metadata.numFrames * input->frameSize;
+    size_t copied = 0;
+
+    while (copied < size && input->position < streamSize) {
+        size_t chunk;
+        if (input->position < (int64_t)sizeof(VideoMetadata)) {
+            // Decoded header, without the compression flag
+            chunk = sizeof(VideoMetadata) - input->position;
+            if (chunk > size - copied) chunk = size - copied;
+            memcpy(buf + copied,
+                   (const char *)&input->metadata + input->position, chunk);
+        } else {
+            int64_t offset = input->position - sizeof(VideoMetadata);
+            int64_t frame = offset / input->frameSize;
+            if (frame < input->windowStart
+                    || frame >= input->windowStart + input->windowFrames) {
+                int status = input->gopOffsets
+                    ? load_indexed_window(input, frame)
+                    : load_sequential_window(input, frame);
+                if (status != 0) {
+                    return copied ? (ssize_t)copied : -1;
+                }
+            }
+            int64_t windowOffset = offset
+                                 - input->windowStart * input->frameSize;
+            chunk = input->windowFrames * input->frameSize - windowOffset;
+            if (chunk > size - copied) chunk = size - copied;
+            memcpy(buf + copied, input->window + windowOffset, chunk);
+        }
+        copied += chunk;
+        input->position += chunk;
+    }
+    return copied;
+}
+
+static int compressed_seek(void *cookie, off64_t *offset, int whence) {
+    CompressedInput *input = cookie;
+    int64_t streamSize = sizeof(VideoMetadata)
+                       + input->metadata.numFrames * input->frameSize;
+    int64_t target = *offset;
+    if (whence == SEEK_CUR) target += input->position;
+    if (whence == SEEK_END) target += streamSize;
+    if (target < 0) return -1;
+    // Streams can only report their position
+    if (!input->gopOffsets && target != input->position) return -1;
+    input->position = target;
+    *offset = target;
+    return 0;
+}
+
+static int compressed_close(void *cookie) {
+    CompressedInput *input = cookie;
+    int status = fclose(input->file);
+    free(input->gopOffsets);
+    pool_release(input->window);
+    pool_release(input->gopBuffers);
+    free(input);
+    return status;
+}
+
+// The index comes from the file, so check it before sizing buffers from
+// it: offsets ascend from the first payload to the index, which must fit
+// before the trailer
+static bool valid_index(const uint64_t *gopOffsets, int64_t numGops,
+        uint64_t dataStart, uint64_t trailerOffset) {
+    uint64_t indexOffset = gopOffsets[numGops];
+    if (indexOffset > trailerOffset
+            || trailerOffset - indexOffset
+               < (uint64_t)numGops * sizeof(uint64_t)) {
+        return false;
+    }
+    uint64_t previous = dataStart;
+    for (int64_t gop = 0; gop <= numGops; gop++) {
+        if (gopOffsets[gop] < previous) return false;
+        previous = gopOffsets[gop];
+    }
+    return true;
+}
+
+FILE *open_compressed_input(FILE *file, VideoMetadata *metadata) {
+    CompressedInput *input = calloc(1, sizeof(CompressedInput));
+    uint32_t gopSize;
+    if (!input || fread(&gopSize, 4, 1, file) != 1 || gopSize == 0) {
+        fprintf(stderr, "Error: Invalid compressed container.\n");
+        exit(1);
+    }
+
+    metadata->format &= ~FORMAT_COMPRESSED;
+    input->file = file;
+    input->metadata = *metadata;
+    input->frameSize = frame_size(metadata);
+    input->gopSize = gopSize;
+    input->numGops = (metadata->numFrames + gopSize - 1) / gopSize;
+    input->windowGops = 1;
+    size_t decodedGopBytes = input->gopSize * input->frameSize;
+    input->position = sizeof(VideoMetadata);
+
+    // Load the GOP index from the trailer when the file can seek
+    off_t dataStart = ftello(file);
+    uint64_t indexOffset;
+    off_t trailerOffset;
+    bool indexed = false;
+    input->gopOffsets = malloc((input->numGops + 1) * sizeof(uint64_t));
+    if (input->gopOffsets
+            && fseeko(file, -(off_t)sizeof(uint64_t), SEEK_END) == 0
+            && (trailerOffset = ftello(file)) >= 0
+            && fread(&indexOffset, sizeof(uint64_t), 1, file) == 1
+            && indexOffset <= (uint64_t)trailerOffset
+            && fseeko(file, indexOffset, SEEK_SET) == 0
+            && fread(input->gopOffsets, sizeof(uint64_t), input->numGops,
+                     file) == (size_t)input->numGops) {
+        input->gopOffsets[input->numGops] = indexOffset;
+        indexed = valid_index(input->gopOffsets, input->numGops, dataStart,
+                              trailerOffset);
+        if (!indexed) {
+            fprintf(stderr, "Warning: Invalid GOP index, "
+                "decoding compressed input sequentially.\n");
+        }
+    }
+    if (indexed) {
+        // One GOP per thread, within the decoded window budget
+        input->windowGops = omp_get_max_threads();
+        if (input->windowGops * decodedGopBytes > MAX_WINDOW_BYTES) {
+            input->windowGops = MAX_WINDOW_BYTES / decodedGopBytes;
+            if (input->windowGops < 1) input->windowGops = 1;
+        }
+        for (int64_t gop = 0; gop < input->numGops; gop++) {
+            size_t size = input->gopOffsets[gop + 1] - input->gopOffsets[gop];
+            if (size > input->gopBufferSize) input->gopBufferSize = size;
+        }
+    } else {
+        free(input->gopOffsets);
+        input->gopOffsets = NULL;
+        input->gopBufferSize = compressed_bound(input->frameSize);
+        if (fseeko(file, dataStart, SEEK_SET) != 0 && dataStart >= 0) {
+            fprintf(stderr, "Error: Cannot rewind compressed input.\n");
+            exit(1);
+        }
+    }
+
+    input->window = pool_acquire(input->windowGops * decodedGopBytes);
+    input->gopBuffers = pool_acquire(input->windowGops * input->gopBufferSize
+                                     + 1);
+    if (!input->window || !input->gopBuffers) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+
+    cookie_io_functions_t functions = {
+        .read = compressed_read,
+        .write = NULL,
+        .seek = compressed_seek,
+        .close = compressed_close,
+    };
+    FILE *decoded = fopencookie(input, "rb", functions);
+    if (!decoded) {
+        perror("Error opening compressed input");
+        exit(1);
+    }
+    // Continue after the header, as for an uncompressed file
+    fseeko(decoded, sizeof(VideoMetadata), SEEK_SET);
+    return decoded;
+}
+
+void decompress_video(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *metadata) {
+    size_t frameSize = frame_size(metadata);
+    size_t batchSize = 256;  // Number of frames per batch
+    unsigned char *batch = pool_acquire(batchSize * frameSize);
+    if (!batch) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+
+    // The input is already decoded by open_compressed_input
+    for (int64_t framesProcessed = 0; framesProcessed < metadata->numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = metadata->numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+        if (fread(batch, frameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(batch);
+            exit(1);
+        }
+        if (fwrite(batch, frameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            pool_release(batch);
+            exit(1);
+        }
+    }
+    pool_release(batch);
+    printf("Decompression completed successfully.\n");
+}
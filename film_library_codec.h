@@ -0,0 +1,17 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_CODEC_H
+#define LIB_FILMMASTER2000_CODEC_H
+#include <stdio.h>
+#include <stdint.h>
+#include "film_library.h"
+
+size_t compressed_bound(size_t size);
+size_t rle_encode(const unsigned char *src, size_t size, unsigned char *dst);
+int rle_decode(const unsigned char *src, size_t size, unsigned char *dst,
+    size_t dstSize);
+void compress_video(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *inputMetadata, int gopSize);
+void decompress_video(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *metadata);
+FILE *open_compressed_input(FILE *file, VideoMetadata *metadata);
+#endif
@@ -0,0 +1,358 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for exit
+#include <string.h>  // for strcmp
+#include <omp.h>  // for OpenMP parallelization
+#include <immintrin.h>  // for AVX2 intrinsics SIMD
+#include <stdint.h>  // for int64_t type
+#include <stdbool.h>  // for boolean type
+#include "film_library.h"  // for VideoMetadata and format flags
+#include "film_library_simd.h"  // for simd_level
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_colour.h"
+
+// Each output plane is (a * c0 + b * c1 + c * c2 + 128 * c3) >> 14, where
+// c3 folds the 128 chroma offset and the rounding term into one constant.
+// Full-range matrices, so RGB -> YUV -> RGB round-trips closely.
+typedef int16_t ColourRow[4];
+
+static const ColourRow rgbToYuv601[3] = {
+    {4899, 9617, 1868, 64},  // Y
+    {-2765, -5427, 8192, 16448},  // Cb
+    {8192, -6860, -1332, 16448},  // Cr
+};
+static const ColourRow yuvToRgb601[3] = {  // inputs ordered Y, Cb, Cr
+    {16384, 0, 22970, 64 - 22970},  // R
+    {16384, -5638, -11700, 64 + 5638 + 11700},  // G
+    {16384, 29032, 0, 64 - 29032},  // B
+};
+static const ColourRow rgbToYuv709[3] = {
+    {3483, 11718, 1183, 64},
+    {-1877, -6315, 8192, 16448},
+    {8192, -7441, -751, 16448},
+};
+static const ColourRow yuvToRgb709[3] = {
+    {16384, 0, 25802, 64 - 25802},
+    {16384, -3069, -7670, 64 + 3069 + 7670},
+    {16384, 30402, 0, 64 - 30402},
+};
+
+TARGET_AVX2
+static size_t convert_plane_avx2(const unsigned char *a,
+        const unsigned char *b, const unsigned char *c, unsigned char *out,
+        size_t size, const ColourRow row) {
+    size_t pixel = 0;
+    // madd pairs (a, b) and (c, 128) so each lane needs two multiplies
+    __m256i coefAB = _mm256_set1_epi32((uint16_t)row[0]
+                                       | ((uint32_t)(uint16_t)row[1] << 16));
+    __m256i coefCK = _mm256_set1_epi32((uint16_t)row[2]
+                                       | ((uint32_t)(uint16_t)row[3] << 16));
+    __m256i offset = _mm256_set1_epi16(128);
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m256i va = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(a + pixel)));
+        __m256i vb = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(b + pixel)));
+        __m256i vc = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(c + pixel)));
+
+        __m256i lo = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(va, vb), coefAB),
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(vc, offset), coefCK));
+        __m256i hi = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(va, vb), coefAB),
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(vc, offset), coefCK));
+
+        // packs undoes the per-lane unpack order, packus clamps to 8 bits
+        __m256i words = _mm256_packs_epi32(_mm256_srai_epi32(lo, 14),
+                                           _mm256_srai_epi32(hi, 14));
+        __m256i bytes = _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(words, words), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)(out + pixel),
+                         _mm256_castsi256_si128(bytes));
+    }
+    return pixel;
+}
+
+// One output plane from three input planes with a fixed-point matrix row
+static void convert_plane(const unsigned char *a, const unsigned char *b,
+        const unsigned char *c, unsigned char *out, size_t size,
+        const ColourRow row) {
+    size_t pixel = 0;
+    if (simd_level() >= SIMD_AVX2) {
+        pixel = convert_plane_avx2(a, b, c, out, size, row);
+    }
+    for (; pixel < size; pixel++) {
+        int value = (a[pixel] * row[0] + b[pixel] * row[1]
+                     + c[pixel] * row[2] + 128 * row[3]) >> 14;
+        out[pixel] = (unsigned char)(value < 0 ? 0 :
+                                     value > 255 ? 255 : value);
+    }
+}
+
+// One output row of downsample_2x2 up to the last whole 32 input bytes
+TARGET_AVX2
+static int downsample_row_avx2(const unsigned char *row0,
+        const unsigned char *row1, unsigned char *out, int width) {
+    __m256i ones = _mm256_set1_epi8(1);
+    __m256i round = _mm256_set1_epi16(2);
+    int x = 0;
+    for (; 2 * x + 32 <= width; x += 16) {
+        // maddubs sums horizontal pairs into 16-bit lanes
+        __m256i sum = _mm256_add_epi16(
+            _mm256_maddubs_epi16(_mm256_loadu_si256(
+                (const __m256i *)(row0 + 2 * x)), ones),
+            _mm256_maddubs_epi16(_mm256_loadu_si256(
+                (const __m256i *)(row1 + 2 * x)), ones));
+        sum = _mm256_srli_epi16(_mm256_add_epi16(sum, round), 2);
+        __m256i bytes = _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)(out + x),
+                         _mm256_castsi256_si128(bytes));
+    }
+    return x;
+}
+
+// 2x2 box average of a full resolution plane, replicating odd edges
+void downsample_2x2(const unsigned char *src, unsigned char *dst,
+        int height, int width) {
+    int outHeight = (height + 1) / 2;
+    int outWidth = (width + 1) / 2;
+    bool vector = simd_level() >= SIMD_AVX2;
+    for (int y = 0; y < outHeight; y++) {
+        const unsigned char *row0 = src + 2 * y * width;
+        const unsigned char *row1 = 2 * y + 1 < height ? row0 + width : row0;
+        unsigned char *out = dst + y * outWidth;
+        int x = vector ? downsample_row_avx2(row0, row1, out, width) : 0;
+        for (; x < outWidth; x++) {
+            int x1 = 2 * x + 1 < width ? 2 * x + 1 : 2 * x;
+            out[x] = (unsigned char)((row0[2 * x] + row0[x1]
+                                      + row1[2 * x] + row1[x1] + 2) >> 2);
+        }
+    }
+}
+
+// Nearest-neighbour chroma upsample back to full resolution
+static void upsample_chroma(const unsigned char *src, unsigned char *dst,
+        int height, int width) {
+    int inWidth = (width + 1) / 2;
+    for (int y = 0; y < height; y++) {
+        const unsigned char *in = src + (y / 2) * inWidth;
+        unsigned char *out = dst + y * width;
+        for (int x = 0; x < width; x++) {
+            out[x] = in[x / 2];
+        }
+    }
+}
+
+void to_yuv(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        const char *subsamplingStr, const char *matrixStr) {
+    if (channels != 3) {
+        fprintf(stderr, "Error: YUV conversion needs 3 channels.\n");
+        exit(1);
+    }
+
+    unsigned char format = FORMAT_YUV_BT601 | FORMAT_CHROMA_420;
+    if (subsamplingStr != NULL && strcmp(subsamplingStr, "444") == 0) {
+        format = FORMAT_YUV_BT601 | FORMAT_CHROMA_444;
+    } else if (subsamplingStr != NULL && strcmp(subsamplingStr, "420") != 0) {
+        fprintf(stderr, "Error: Subsampling must be 444 or 420.\n");
+        exit(1);
+    }
+    const ColourRow *matrix = rgbToYuv601;
+    if (matrixStr != NULL && strcmp(matrixStr, "709") == 0) {
+        matrix = rgbToYuv709;
+        format = (format & ~FORMAT_COLOUR_MASK) | FORMAT_YUV_BT709;
+    } else if (matrixStr != NULL && strcmp(matrixStr, "601") != 0) {
+        fprintf(stderr, "Error: Matrix must be 601 or 709.\n");
+        exit(1);
+    }
+
+    VideoMetadata metadata = {.numFrames = numFrames, .format = format,
+        .channels = channels, .height = height, .width = width};
+    size_t planeSize = height * width;
+    size_t inFrameSize = planeSize * channels;
+    size_t outFrameSize = frame_size(&metadata);
+    size_t chromaSize = (outFrameSize - planeSize) / 2;
+    bool subsample = (format & FORMAT_CHROMA_MASK) == FORMAT_CHROMA_420;
+    size_t batchSize = 256;  // Number of frames per batch
+    int numThreads = omp_get_max_threads();
+
+    unsigned char *inBatch = pool_acquire(batchSize * inFrameSize);
+    unsigned char *outBatch = pool_acquire(batchSize * outFrameSize);
+    // Full resolution chroma before subsampling, one pair per thread
+    unsigned char *chromaScratch = pool_acquire(numThreads * 2 * planeSize);
+    if (!inBatch || !outBatch || !chromaScratch) {
+        perror("Error allocating memory");
+        pool_release(inBatch);
+        pool_release(outBatch);
+        pool_release(chromaScratch);
+        exit(1);
+    }
+
+    fseek(outputFile, 0, SEEK_SET);
+    if (fwrite(&metadata, sizeof(VideoMetadata), 1, outputFile) != 1) {
+        perror("Error writing metadata");
+        pool_release(inBatch);
+        pool_release(outBatch);
+        pool_release(chromaScratch);
+        exit(1);
+    }
+
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(inBatch, inFrameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            pool_release(chromaScratch);
+            exit(1);
+        }
+
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            const unsigned char *r = inBatch + frame * inFrameSize;
+            const unsigned char *g = r + planeSize;
+            const unsigned char *b = g + planeSize;
+            unsigned char *y = outBatch + frame * outFrameSize;
+
+            convert_plane(r, g, b, y, planeSize, matrix[0]);
+            if (subsample) {
+                unsigned char *fullCb = chromaScratch
+                    + omp_get_thread_num() * 2 * planeSize;
+                unsigned char *fullCr = fullCb + planeSize;
+                convert_plane(r, g, b, fullCb, planeSize, matrix[1]);
+                convert_plane(r, g, b, fullCr, planeSize, matrix[2]);
+                downsample_2x2(fullCb, y + planeSize, height, width);
+                downsample_2x2(fullCr, y + planeSize + chromaSize,
+                    height, width);
+            } else {
+                convert_plane(r, g, b, y + planeSize, planeSize, matrix[1]);
+                convert_plane(r, g, b, y + 2 * planeSize, planeSize,
+                    matrix[2]);
+            }
+        }
+
+        if (fwrite(outBatch, outFrameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            pool_release(chromaScratch);
+            exit(1);
+        }
+    }
+
+    pool_release(inBatch);
+    pool_release(outBatch);
+    pool_release(chromaScratch);
+    printf("YUV conversion completed successfully.\n");
+}
+
+void to_rgb(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *inputMetadata) {
+    unsigned char colour = inputMetadata->format & FORMAT_COLOUR_MASK;
+    if (colour == FORMAT_RGB) {
+        fprintf(stderr, "Error: Input is already RGB.\n");
+        exit(1);
+    }
+    if (inputMetadata->channels != 3) {
+        fprintf(stderr, "Error: YUV conversion needs 3 channels.\n");
+        exit(1);
+    }
+
+    const ColourRow *matrix = colour == FORMAT_YUV_BT709 ? yuvToRgb709
+                                                        : yuvToRgb601;
+    int64_t numFrames = inputMetadata->numFrames;
+    unsigned char height = inputMetadata->height;
+    unsigned char width = inputMetadata->width;
+    bool subsampled = (inputMetadata->format & FORMAT_CHROMA_MASK)
+                      == FORMAT_CHROMA_420;
+
+    VideoMetadata metadata = {.numFrames = numFrames, .format = FORMAT_RGB,
+        .channels = 3, .height = height, .width = width};
+    size_t planeSize = height * width;
+    size_t inFrameSize = frame_size(inputMetadata);
+    size_t outFrameSize = frame_size(&metadata);
+    size_t chromaSize = (inFrameSize - planeSize) / 2;
+    size_t batchSize = 256;  // Number of frames per batch
+    int numThreads = omp_get_max_threads();
+
+    unsigned char *inBatch = pool_acquire(batchSize * inFrameSize);
+    unsigned char *outBatch = pool_acquire(batchSize * outFrameSize);
+    unsigned char *chromaScratch = pool_acquire(numThreads * 2 * planeSize);
+    if (!inBatch || !outBatch || !chromaScratch) {
+        perror("Error allocating memory");
+        pool_release(inBatch);
+        pool_release(outBatch);
+        pool_release(chromaScratch);
+        exit(1);
+    }
+
+    fseek(outputFile, 0, SEEK_SET);
+    if (fwrite(&metadata, sizeof(VideoMetadata), 1, outputFile) != 1) {
+        perror("Error writing metadata");
+        pool_release(inBatch);
+        pool_release(outBatch);
+        pool_release(chromaScratch);
+        exit(1);
+    }
+
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(inBatch, inFrameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            pool_release(chromaScratch);
+            exit(1);
+        }
+
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            const unsigned char *y = inBatch + frame * inFrameSize;
+            const unsigned char *cb = y + planeSize;
+            const unsigned char *cr = subsampled ? cb + chromaSize
+                                                 : cb + planeSize;
+            unsigned char *r = outBatch + frame * outFrameSize;
+
+            if (subsampled) {
+                unsigned char *fullCb = chromaScratch
+                    + omp_get_thread_num() * 2 * planeSize;
+                unsigned char *fullCr = fullCb + planeSize;
+                upsample_chroma(cb, fullCb, height, width);
+                upsample_chroma(cr, fullCr, height, width);
+                cb = fullCb;
+                cr = fullCr;
+            }
+            convert_plane(y, cb, cr, r, planeSize, matrix[0]);
+            convert_plane(y, cb, cr, r + planeSize, planeSize, matrix[1]);
+            convert_plane(y, cb, cr, r + 2 * planeSize, planeSize,
+                matrix[2]);
+        }
+
+        if (fwrite(outBatch, outFrameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            pool_release(chromaScratch);
+            exit(1);
+        }
+    }
+
+    pool_release(inBatch);
+    pool_release(outBatch);
+    pool_release(chromaScratch);
+    printf("RGB conversion completed successfully.\n");
+}
@@ -0,0 +1,15 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_COLOUR_H
+#define LIB_FILMMASTER2000_COLOUR_H
+#include <stdio.h>
+#include <stdint.h>
+#include "film_library.h"
+
+void downsample_2x2(const unsigned char *src, unsigned char *dst,
+    int height, int width);
+void to_yuv(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels,
+    const char *subsamplingStr, const char *matrixStr);
+void to_rgb(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *inputMetadata);
+#endif
@@ -0,0 +1,230 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for exit, strtod
+#include <string.h>  // for strcmp
+#include <math.h>  // for lround
+#include <omp.h>  // for OpenMP parallelization
+#include <stdint.h>  // for int64_t type
+#include <stdbool.h>  // for boolean type
+#include "film_library.h"  // for VideoMetadata and update_metadata
+#include "film_library_edit.h"  // for open_clip
+#include "film_library_simd.h"  // for blend_planes and blend_planes_alpha
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_composite.h"
+
+#define BATCH_FRAMES 64
+
+typedef struct {
+    size_t planeSize;
+    unsigned char channels;
+    size_t frameSize;  // of the base and the output
+    size_t topFrameSize;  // larger by one plane when it carries alpha
+    bool alphaPlane;
+    int64_t fadeFrames;  // when set the weight ramps up over the frames
+    int weight;  // otherwise one weight for every pixel, 0 to 256
+} Blend;
+
+static void blend_frame(const unsigned char *base, const unsigned char *top,
+        unsigned char *output, int64_t frame, const Blend *blend) {
+    int weight = blend->weight;
+    if (blend->fadeFrames > 0) {
+        // Neither end of the fade repeats a frame of the clips
+        weight = ((frame + 1) * 256 + (blend->fadeFrames + 1) / 2)
+               / (blend->fadeFrames + 1);
+    }
+    for (unsigned char ch = 0; ch < blend->channels; ch++) {
+        size_t offset = ch * blend->planeSize;
+        if (blend->alphaPlane) {
+            blend_planes_alpha(base + offset, top + offset,
+                top + blend->channels * blend->planeSize, output + offset,
+                blend->planeSize);
+        } else {
+            blend_planes(base + offset, top + offset, output + offset,
+                blend->planeSize, weight);
+        }
+    }
+}
+
+static void copy_stream(FILE *inputFile, FILE *outputFile, int64_t count,
+        size_t frameSize) {
+    unsigned char *batch = pool_acquire(BATCH_FRAMES * frameSize);
+    if (!batch) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    for (int64_t done = 0; done < count; done += BATCH_FRAMES) {
+        size_t frames = count - done < BATCH_FRAMES ? count - done
+                                                    : BATCH_FRAMES;
+        if (fread(batch, frameSize, frames, inputFile) != frames) {
+            perror("Error reading frame data");
+            pool_release(batch);
+            exit(1);
+        }
+        if (fwrite(batch, frameSize, frames, outputFile) != frames) {
+            perror("Error writing frame data");
+            pool_release(batch);
+            exit(1);
+        }
+    }
+    pool_release(batch);
+}
+
+static void release_batches(unsigned char *baseBatch[2],
+        unsigned char *topBatch[2], unsigned char *outBatch) {
+    for (int i = 0; i < 2; i++) {
+        pool_release(baseBatch[i]);
+        pool_release(topBatch[i]);
+    }
+    pool_release(outBatch);
+}
+
+// Reads count frames from both inputs in step and writes their blend
+static void blend_stream(FILE *base, FILE *top, FILE *outputFile,
+        int64_t count, const Blend *blend) {
+    unsigned char *baseBatch[2], *topBatch[2];
+    for (int i = 0; i < 2; i++) {
+        baseBatch[i] = pool_acquire(BATCH_FRAMES * blend->frameSize);
+        topBatch[i] = pool_acquire(BATCH_FRAMES * blend->topFrameSize);
+    }
+    unsigned char *outBatch = pool_acquire(BATCH_FRAMES * blend->frameSize);
+    if (!baseBatch[0] || !baseBatch[1] || !topBatch[0] || !topBatch[1]
+            || !outBatch) {
+        perror("Error allocating memory");
+        release_batches(baseBatch, topBatch, outBatch);
+        exit(1);
+    }
+
+    size_t firstFrames = count < BATCH_FRAMES ? count : BATCH_FRAMES;
+    if (fread(baseBatch[0], blend->frameSize, firstFrames, base)
+            != firstFrames
+            || fread(topBatch[0], blend->topFrameSize, firstFrames, top)
+            != firstFrames) {
+        perror("Error reading frame data");
+        release_batches(baseBatch, topBatch, outBatch);
+        exit(1);
+    }
+
+    for (int64_t first = 0; first < count; first += BATCH_FRAMES) {
+        int current = (first / BATCH_FRAMES) % 2;
+        int next = 1 - current;
+        int64_t framesInBatch = count - first < BATCH_FRAMES ? count - first
+                                                             : BATCH_FRAMES;
+        int64_t remaining = count - first - framesInBatch;
+        size_t nextFrames = remaining < BATCH_FRAMES ? remaining
+                                                     : BATCH_FRAMES;
+        bool readFailed = false;
+
+        #pragma omp parallel
+        #pragma omp single
+        {
+            // Both inputs load their next batch while this one is blended
+            if (nextFrames > 0) {
+                #pragma omp task shared(readFailed)
+                if (fread(baseBatch[next], blend->frameSize, nextFrames,
+                        base) != nextFrames) {
+                    #pragma omp atomic write
+                    readFailed = true;
+                }
+                #pragma omp task shared(readFailed)
+                if (fread(topBatch[next], blend->topFrameSize, nextFrames,
+                        top) != nextFrames) {
+                    #pragma omp atomic write
+                    readFailed = true;
+                }
+            }
+            #pragma omp taskloop
+            for (int64_t frame = 0; frame < framesInBatch; frame++) {
+                blend_frame(baseBatch[current] + frame * blend->frameSize,
+                            topBatch[current] + frame * blend->topFrameSize,
+                            outBatch + frame * blend->frameSize,
+                            first + frame, blend);
+            }
+        }
+
+        if (readFailed) {
+            perror("Error reading frame data");
+            release_batches(baseBatch, topBatch, outBatch);
+            exit(1);
+        }
+        if (fwrite(outBatch, blend->frameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            release_batches(baseBatch, topBatch, outBatch);
+            exit(1);
+        }
+    }
+    release_batches(baseBatch, topBatch, outBatch);
+}
+
+void crossfade(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *metadata, const char *clipPath,
+        int64_t fadeFrames) {
+    VideoMetadata clipMetadata;
+    FILE *clip = open_clip(clipPath, metadata, &clipMetadata);
+    int64_t shorter = metadata->numFrames < clipMetadata.numFrames
+                    ? metadata->numFrames : clipMetadata.numFrames;
+    if (fadeFrames < 0 || fadeFrames > shorter) {
+        fprintf(stderr, "Error: Crossfade length must be between 0 and "
+            "%ld frames.\n", shorter);
+        fclose(clip);
+        exit(1);
+    }
+
+    Blend blend = {0};
+    blend.planeSize = metadata->height * metadata->width;
+    blend.channels = metadata->channels;
+    blend.frameSize = frame_size(metadata);
+    blend.topFrameSize = blend.frameSize;
+    blend.fadeFrames = fadeFrames;
+
+    int64_t totalFrames = metadata->numFrames + clipMetadata.numFrames
+                        - fadeFrames;
+    update_metadata(outputFile, totalFrames, metadata->height,
+        metadata->width);
+    copy_stream(inputFile, outputFile, metadata->numFrames - fadeFrames,
+        blend.frameSize);
+    blend_stream(inputFile, clip, outputFile, fadeFrames, &blend);
+    copy_stream(clip, outputFile, clipMetadata.numFrames - fadeFrames,
+        blend.frameSize);
+    fclose(clip);
+    printf("Crossfade completed successfully. %ld frames.\n", totalFrames);
+}
+
+void overlay(FILE *inputFile, FILE *outputFile, const VideoMetadata *metadata,
+        const char *topPath, const char *alpha) {
+    Blend blend = {0};
+    blend.planeSize = metadata->height * metadata->width;
+    blend.channels = metadata->channels;
+    blend.frameSize = frame_size(metadata);
+    blend.topFrameSize = blend.frameSize;
+
+    // Top carries its own alpha as one more plane after the colour ones
+    VideoMetadata expected = *metadata;
+    if (strcmp(alpha, "alpha-channel") == 0) {
+        blend.alphaPlane = true;
+        blend.topFrameSize += blend.planeSize;
+        expected.channels++;
+    } else {
+        char *end;
+        double opacity = strtod(alpha, &end);
+        if (end == alpha || *end != '\0' || opacity < 0 || opacity > 1) {
+            fprintf(stderr, "Error: Overlay alpha must be between 0 and 1, "
+                "or alpha-channel.\n");
+            exit(1);
+        }
+        blend.weight = lround(opacity * 256);
+    }
+
+    VideoMetadata topMetadata;
+    FILE *top = open_clip(topPath, &expected, &topMetadata);
+    int64_t covered = topMetadata.numFrames < metadata->numFrames
+                    ? topMetadata.numFrames : metadata->numFrames;
+    // Base frames past the end of top pass through unchanged
+    blend_stream(inputFile, top, outputFile, covered, &blend);
+    copy_stream(inputFile, outputFile, metadata->numFrames - covered,
+        blend.frameSize);
+    fclose(top);
+    printf("Overlay completed successfully. %ld of %ld frames covered.\n",
+        covered, (int64_t)metadata->numFrames);
+}
@@ -0,0 +1,16 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_COMPOSITE_H
+#define LIB_FILMMASTER2000_COMPOSITE_H
+#include <stdio.h>
+#include <stdint.h>
+#include "film_library.h"
+
+// The input, then the clip, with their last and first fadeFrames frames
+// mixed together
+void crossfade(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *metadata, const char *clipPath, int64_t fadeFrames);
+// Lays each frame of top over the same frame of the input, either with one
+// opacity from 0 to 1 or, for "alpha-channel", with top's extra last plane
+void overlay(FILE *inputFile, FILE *outputFile, const VideoMetadata *metadata,
+    const char *topPath, const char *alpha);
+#endif
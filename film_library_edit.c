@@ -0,0 +1,235 @@
+// Copyright 2025 Rose Laird
+
+#define _GNU_SOURCE  // for copy_file_range
+#include <stdio.h>
+#include <stdlib.h>  // for exit, malloc, free
+#include <unistd.h>  // for copy_file_range, pread, pwrite
+#include <errno.h>  // for errno
+#include <stdint.h>  // for int64_t type
+#include "film_library.h"  // for VideoMetadata and frame_size
+#include "film_library_codec.h"  // for open_compressed_input
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_edit.h"
+
+#define COPY_CHUNK (1 << 20)
+
+// Copy bytes between descriptors in the kernel with copy_file_range where
+// it is supported, otherwise with a bounce buffer. Frames sit at 11 plus a
+// multiple of the frame size, never block aligned, so this is always a
+// data copy rather than a reflink. Returns 0 on success.
+static int copy_range_fd(int inFd, off_t inOffset, int outFd,
+        off_t outOffset, size_t length) {
+    while (length > 0) {
+        ssize_t copied = copy_file_range(inFd, &inOffset, outFd, &outOffset,
+                                         length, 0);
+        if (copied > 0) {
+            length -= copied;
+            continue;
+        }
+        if (copied == 0) return -1;  // input ended early
+        if (errno != EXDEV && errno != ENOSYS && errno != EINVAL
+                && errno != EOPNOTSUPP) {
+            return -1;
+        }
+
+        // Not supported between these files, fall back to pread/pwrite
+        unsigned char *buffer = pool_acquire(COPY_CHUNK);
+        if (!buffer) return -1;
+        while (length > 0) {
+            size_t chunk = length < COPY_CHUNK ? length : COPY_CHUNK;
+            ssize_t bytesRead = pread(inFd, buffer, chunk, inOffset);
+            if (bytesRead <= 0
+                    || pwrite(outFd, buffer, bytesRead, outOffset)
+                       != bytesRead) {
+                pool_release(buffer);
+                return -1;
+            }
+            inOffset += bytesRead;
+            outOffset += bytesRead;
+            length -= bytesRead;
+        }
+        pool_release(buffer);
+    }
+    return 0;
+}
+
+// Seek a stream that may only read forwards, such as a compressed input
+// without an index, by discarding the bytes in between
+static int seek_forward(FILE *file, off_t offset, unsigned char *buffer) {
+    if (fseeko(file, offset, SEEK_SET) == 0) return 0;
+    off_t position = ftello(file);
+    if (position < 0 || position > offset) return -1;
+    while (position < offset) {
+        size_t chunk = offset - position < COPY_CHUNK ? offset - position
+                                                      : COPY_CHUNK;
+        if (fread(buffer, 1, chunk, file) != chunk) return -1;
+        position += chunk;
+    }
+    return 0;
+}
+
+// Copy count frames starting at frame of input to byte offset of output
+static void copy_frames(FILE *inputFile, int64_t frame, int64_t count,
+        size_t frameSize, FILE *outputFile, off_t *outOffset) {
+    if (count <= 0) return;
+    size_t length = count * frameSize;
+    off_t inOffset = sizeof(VideoMetadata) + frame * frameSize;
+    int inFd = fileno(inputFile);
+    int outFd = fileno(outputFile);
+
+    fflush(outputFile);
+    if (inFd != -1 && outFd != -1) {
+        if (copy_range_fd(inFd, inOffset, outFd, *outOffset, length) != 0) {
+            perror("Error copying frame data");
+            exit(1);
+        }
+    } else {
+        // Decoded input has no descriptor, copy through stdio instead
+        unsigned char *buffer = pool_acquire(COPY_CHUNK);
+        if (!buffer) {
+            perror("Error allocating memory");
+            exit(1);
+        }
+        if (seek_forward(inputFile, inOffset, buffer) != 0
+                || fseeko(outputFile, *outOffset, SEEK_SET) != 0) {
+            perror("Error seeking to frame data");
+            pool_release(buffer);
+            exit(1);
+        }
+        for (size_t done = 0; done < length;) {
+            size_t chunk = length - done < COPY_CHUNK ? length - done
+                                                      : COPY_CHUNK;
+            if (fread(buffer, 1, chunk, inputFile) != chunk
+                    || fwrite(buffer, 1, chunk, outputFile) != chunk) {
+                perror("Error copying frame data");
+                pool_release(buffer);
+                exit(1);
+            }
+            done += chunk;
+        }
+        fflush(outputFile);
+        pool_release(buffer);
+    }
+    *outOffset += length;
+}
+
+FILE *try_open_clip(const char *path, const VideoMetadata *expected,
+        VideoMetadata *metadata) {
+    FILE *clip = fopen(path, "rb");
+    if (!clip) {
+        perror("Error opening clip");
+        return NULL;
+    }
+    if (fread(metadata, sizeof(VideoMetadata), 1, clip) != 1) {
+        perror("Error reading clip metadata");
+        fclose(clip);
+        return NULL;
+    }
+    if (metadata->format & FORMAT_COMPRESSED) {
+        clip = open_compressed_input(clip, metadata);
+    }
+    if (metadata->format != expected->format
+            || metadata->channels != expected->channels
+            || metadata->height != expected->height
+            || metadata->width != expected->width) {
+        fprintf(stderr, "Error: %s has a different format or resolution "
+            "(%dx%dx%d).\n", path, metadata->channels, metadata->height,
+            metadata->width);
+        fclose(clip);
+        return NULL;
+    }
+    return clip;
+}
+
+FILE *open_clip(const char *path, const VideoMetadata *expected,
+        VideoMetadata *metadata) {
+    FILE *clip = try_open_clip(path, expected, metadata);
+    if (!clip) exit(1);
+    return clip;
+}
+
+// Written before any frames, so the output can be a pipe
+static void write_edit_header(FILE *outputFile,
+        const VideoMetadata *metadata, int64_t numFrames) {
+    update_metadata(outputFile, numFrames, metadata->height,
+        metadata->width);
+    fflush(outputFile);
+}
+
+void trim(FILE *inputFile, FILE *outputFile, const VideoMetadata *metadata,
+        int64_t start, int64_t end) {
+    if (start < 0 || end > metadata->numFrames || start > end) {
+        fprintf(stderr, "Error: Trim range must satisfy "
+            "0 <= start <= end <= %ld.\n", (int64_t)metadata->numFrames);
+        exit(1);
+    }
+
+    off_t outOffset = sizeof(VideoMetadata);
+    write_edit_header(outputFile, metadata, end - start);
+    copy_frames(inputFile, start, end - start, frame_size(metadata),
+        outputFile, &outOffset);
+    printf("Trim completed successfully. Kept frames [%ld, %ld).\n",
+        start, end);
+}
+
+void concat(FILE *inputFile, FILE *outputFile, const VideoMetadata *metadata,
+        char **clipPaths, int numClips) {
+    size_t frameSize = frame_size(metadata);
+    off_t outOffset = sizeof(VideoMetadata);
+    int64_t totalFrames = metadata->numFrames;
+    FILE **clips = malloc(numClips * sizeof(FILE *));
+    VideoMetadata *clipMetadata = malloc(numClips * sizeof(VideoMetadata));
+    if (!clips || !clipMetadata) {
+        perror("Error allocating memory");
+        free(clips);
+        free(clipMetadata);
+        exit(1);
+    }
+
+    // Every clip is checked and counted before the first frame goes out
+    for (int i = 0; i < numClips; i++) {
+        clips[i] = open_clip(clipPaths[i], metadata, &clipMetadata[i]);
+        totalFrames += clipMetadata[i].numFrames;
+    }
+    write_edit_header(outputFile, metadata, totalFrames);
+
+    copy_frames(inputFile, 0, metadata->numFrames, frameSize, outputFile,
+        &outOffset);
+    for (int i = 0; i < numClips; i++) {
+        copy_frames(clips[i], 0, clipMetadata[i].numFrames, frameSize,
+            outputFile, &outOffset);
+        fclose(clips[i]);
+    }
+    free(clips);
+    free(clipMetadata);
+
+    printf("Concatenation completed successfully. %ld frames.\n",
+        totalFrames);
+}
+
+void splice(FILE *inputFile, FILE *outputFile, const VideoMetadata *metadata,
+        int64_t start, int64_t end, const char *clipPath) {
+    if (start < 0 || end > metadata->numFrames || start > end) {
+        fprintf(stderr, "Error: Splice range must satisfy "
+            "0 <= start <= end <= %ld.\n", (int64_t)metadata->numFrames);
+        exit(1);
+    }
+
+    size_t frameSize = frame_size(metadata);
+    off_t outOffset = sizeof(VideoMetadata);
+    VideoMetadata clipMetadata;
+    FILE *clip = open_clip(clipPath, metadata, &clipMetadata);
+    int64_t totalFrames = metadata->numFrames - (end - start)
+                        + clipMetadata.numFrames;
+    write_edit_header(outputFile, metadata, totalFrames);
+
+    // Frames before the range, the clip in its place, then the rest
+    copy_frames(inputFile, 0, start, frameSize, outputFile, &outOffset);
+    copy_frames(clip, 0, clipMetadata.numFrames, frameSize, outputFile,
+        &outOffset);
+    copy_frames(inputFile, end, metadata->numFrames - end, frameSize,
+        outputFile, &outOffset);
+    fclose(clip);
+
+    printf("Splice completed successfully. %ld frames.\n", totalFrames);
+}
@@ -0,0 +1,21 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_EDIT_H
+#define LIB_FILMMASTER2000_EDIT_H
+#include <stdio.h>
+#include <stdint.h>
+#include "film_library.h"
+
+// Opens a clip, or prints why it cannot be joined to expected and returns
+// NULL. A corrupt compressed container still exits.
+FILE *try_open_clip(const char *path, const VideoMetadata *expected,
+    VideoMetadata *metadata);
+// As try_open_clip, but exits on error
+FILE *open_clip(const char *path, const VideoMetadata *expected,
+    VideoMetadata *metadata);
+void trim(FILE *inputFile, FILE *outputFile, const VideoMetadata *metadata,
+    int64_t start, int64_t end);
+void concat(FILE *inputFile, FILE *outputFile, const VideoMetadata *metadata,
+    char **clipPaths, int numClips);
+void splice(FILE *inputFile, FILE *outputFile, const VideoMetadata *metadata,
+    int64_t start, int64_t end, const char *clipPath);
+#endif
@@ -0,0 +1,508 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for malloc, realloc, free
+#include <string.h>  // for memcpy, strchr, strcmp, strtok
+#include <stdbool.h>  // for boolean type
+#include <unistd.h>  // for pread
+#include <omp.h>  // for OpenMP parallelization
+#include "film_library.h"  // for VideoMetadata, frame_size, update_metadata
+#include "film_library_plus.h"  // for parse_aspect_ratio, speed_up_frames
+#include "film_library_simd.h"  // for apply_lut
+#include "film_library_edit.h"  // for open_clip
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_edl.h"
+
+#define BATCH_SIZE 256
+#define MAX_EDL_LINE 1024
+
+typedef struct {
+    FILE *file;
+    VideoMetadata metadata;
+    bool owned;
+} EditSource;
+
+// Output frame i of a segment is frame start + i * step of its source, a
+// negative step runs backwards. Each segment keeps its own pixel transform
+// so clips concatenated later are not affected by earlier operations.
+typedef struct {
+    int source;
+    int64_t start;
+    int64_t step;
+    int64_t count;
+    int cropTop;
+    int cropLeft;
+    unsigned char *sourceChannel;  // source plane of each output channel
+    unsigned char (*lookupTables)[256];  // applied after the plane lookup
+} EditSegment;
+
+struct EditList {
+    VideoMetadata metadata;  // of the rendered output
+    EditSource *sources;
+    int numSources;
+    EditSegment *segments;
+    int numSegments;
+};
+
+static void *checked_realloc(void *data, size_t size) {
+    void *resized = realloc(data, size);
+    if (!resized) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    return resized;
+}
+
+// Append a segment covering a whole source with no pixel transform
+static void add_segment(EditList *edl, int source) {
+    unsigned char channels = edl->metadata.channels;
+    edl->segments = checked_realloc(edl->segments,
+        (edl->numSegments + 1) * sizeof(EditSegment));
+    EditSegment *segment = &edl->segments[edl->numSegments++];
+    segment->source = source;
+    segment->start = 0;
+    segment->step = 1;
+    segment->count = edl->sources[source].metadata.numFrames;
+    segment->cropTop = 0;
+    segment->cropLeft = 0;
+    segment->sourceChannel = checked_realloc(NULL, channels);
+    segment->lookupTables = checked_realloc(NULL, channels * 256);
+    for (int ch = 0; ch < channels; ch++) {
+        segment->sourceChannel[ch] = ch;
+        for (int value = 0; value < 256; value++) {
+            segment->lookupTables[ch][value] = value;
+        }
+    }
+}
+
+static void free_segment(EditSegment *segment) {
+    free(segment->sourceChannel);
+    free(segment->lookupTables);
+}
+
+// Drop segments that no longer contribute any frames
+static void remove_empty_segments(EditList *edl) {
+    int kept = 0;
+    for (int i = 0; i < edl->numSegments; i++) {
+        if (edl->segments[i].count > 0) {
+            edl->segments[kept++] = edl->segments[i];
+        } else {
+            free_segment(&edl->segments[i]);
+        }
+    }
+    edl->numSegments = kept;
+}
+
+static bool is_full_resolution(const EditList *edl) {
+    if ((edl->metadata.format & FORMAT_CHROMA_MASK) != FORMAT_CHROMA_444) {
+        fprintf(stderr, "Error: Pixel operations need full resolution "
+            "planes, convert 4:2:0 input with to_rgb first.\n");
+        return false;
+    }
+    return true;
+}
+
+EditList *edl_create(FILE *source, const VideoMetadata *metadata) {
+    EditList *edl = calloc(1, sizeof(EditList));
+    if (!edl) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    edl->metadata = *metadata;
+    edl->sources = checked_realloc(NULL, sizeof(EditSource));
+    edl->sources[0] = (EditSource){source, *metadata, false};
+    edl->numSources = 1;
+    add_segment(edl, 0);
+    return edl;
+}
+
+void edl_free(EditList *edl) {
+    if (!edl) return;
+    for (int i = 0; i < edl->numSegments; i++) {
+        free_segment(&edl->segments[i]);
+    }
+    for (int i = 0; i < edl->numSources; i++) {
+        if (edl->sources[i].owned) fclose(edl->sources[i].file);
+    }
+    free(edl->segments);
+    free(edl->sources);
+    free(edl);
+}
+
+int64_t edl_num_frames(const EditList *edl) {
+    int64_t numFrames = 0;
+    for (int i = 0; i < edl->numSegments; i++) {
+        numFrames += edl->segments[i].count;
+    }
+    return numFrames;
+}
+
+int edl_reverse(EditList *edl) {
+    // Reverse the segment order and run each one backwards from its end
+    for (int i = 0, j = edl->numSegments - 1; i < j; i++, j--) {
+        EditSegment segment = edl->segments[i];
+        edl->segments[i] = edl->segments[j];
+        edl->segments[j] = segment;
+    }
+    for (int i = 0; i < edl->numSegments; i++) {
+        EditSegment *segment = &edl->segments[i];
+        segment->start += (segment->count - 1) * segment->step;
+        segment->step = -segment->step;
+    }
+    return 0;
+}
+
+int edl_speed_up(EditList *edl, int speedFactor) {
+    if (speedFactor <= 1) {
+        fprintf(stderr, "Error: Speed factor must be greater than 1.\n");
+        return -1;
+    }
+
+    // Keep output frames 0, N, 2N... up to the count speed_up writes, each
+    // segment keeps a stride of N from its first kept frame
+    int64_t keep = speed_up_frames(edl_num_frames(edl), speedFactor);
+    int64_t position = 0;
+    for (int i = 0; i < edl->numSegments; i++) {
+        EditSegment *segment = &edl->segments[i];
+        int64_t first = (position + speedFactor - 1) / speedFactor;
+        int64_t local = first * speedFactor - position;
+        int64_t kept = 0;
+        if (local < segment->count && first < keep) {
+            kept = (segment->count - local + speedFactor - 1) / speedFactor;
+            if (kept > keep - first) kept = keep - first;
+        }
+        position += segment->count;
+        segment->start += local * segment->step;
+        segment->step *= speedFactor;
+        segment->count = kept;
+    }
+    remove_empty_segments(edl);
+    return 0;
+}
+
+int edl_trim(EditList *edl, int64_t start, int64_t end) {
+    int64_t numFrames = edl_num_frames(edl);
+    if (start < 0 || end > numFrames || start > end) {
+        fprintf(stderr, "Error: Trim range must satisfy "
+            "0 <= start <= end <= %ld.\n", numFrames);
+        return -1;
+    }
+
+    int64_t position = 0;
+    for (int i = 0; i < edl->numSegments; i++) {
+        EditSegment *segment = &edl->segments[i];
+        int64_t first = start > position ? start - position : 0;
+        int64_t last = end - position < segment->count ? end - position
+                                                       : segment->count;
+        position += segment->count;
+        segment->start += first * segment->step;
+        segment->count = last > first ? last - first : 0;
+    }
+    remove_empty_segments(edl);
+    return 0;
+}
+
+int edl_concat(EditList *edl, const char *clipPath) {
+    VideoMetadata metadata;
+    FILE *clip = try_open_clip(clipPath, &edl->metadata, &metadata);
+    if (!clip) return -1;
+    edl->sources = checked_realloc(edl->sources,
+        (edl->numSources + 1) * sizeof(EditSource));
+    edl->sources[edl->numSources] = (EditSource){clip, metadata, true};
+    add_segment(edl, edl->numSources++);
+    return 0;
+}
+
+int edl_swap_channel(EditList *edl, unsigned char ch1, unsigned char ch2) {
+    if (ch1 >= edl->metadata.channels || ch2 >= edl->metadata.channels) {
+        fprintf(stderr, "Error: Invalid channel index\n");
+        return -1;
+    }
+    if (!is_full_resolution(edl)) return -1;
+
+    for (int i = 0; i < edl->numSegments; i++) {
+        EditSegment *segment = &edl->segments[i];
+        unsigned char plane = segment->sourceChannel[ch1];
+        segment->sourceChannel[ch1] = segment->sourceChannel[ch2];
+        segment->sourceChannel[ch2] = plane;
+
+        unsigned char lookupTable[256];
+        memcpy(lookupTable, segment->lookupTables[ch1], 256);
+        memcpy(segment->lookupTables[ch1], segment->lookupTables[ch2], 256);
+        memcpy(segment->lookupTables[ch2], lookupTable, 256);
+    }
+    return 0;
+}
+
+int edl_clip_channel(EditList *edl, unsigned char channel,
+        unsigned char min, unsigned char max) {
+    if (channel >= edl->metadata.channels) {
+        fprintf(stderr, "Error: Invalid channel index\n");
+        return -1;
+    }
+    if (!is_full_resolution(edl)) return -1;
+
+    // Clipping composes with earlier pixel operations through the table
+    for (int i = 0; i < edl->numSegments; i++) {
+        unsigned char *lookupTable = edl->segments[i].lookupTables[channel];
+        for (int value = 0; value < 256; value++) {
+            if (lookupTable[value] > max) {
+                lookupTable[value] = max;
+            } else if (lookupTable[value] < min) {
+                lookupTable[value] = min;
+            }
+        }
+    }
+    return 0;
+}
+
+int edl_scale_channel(EditList *edl, unsigned char channel, float factor) {
+    if (channel >= edl->metadata.channels) {
+        fprintf(stderr, "Error: Invalid channel index\n");
+        return -1;
+    }
+    if (!is_full_resolution(edl)) return -1;
+
+    for (int i = 0; i < edl->numSegments; i++) {
+        unsigned char *lookupTable = edl->segments[i].lookupTables[channel];
+        for (int value = 0; value < 256; value++) {
+            // Same rounding as scale_channel
+            float scaledValue = lookupTable[value] * factor;
+            if (scaledValue > 255) {
+                lookupTable[value] = 255;
+            } else if (scaledValue < 0) {
+                lookupTable[value] = 0;
+            } else {
+                lookupTable[value] = (unsigned char)scaledValue;
+            }
+        }
+    }
+    return 0;
+}
+
+int edl_crop_aspect(EditList *edl, const char *aspectRatioStr) {
+    if (!is_full_resolution(edl)) return -1;
+
+    // Same target size and centring as crop_aspect_ratio
+    float targetAspectRatio = parse_aspect_ratio(aspectRatioStr);
+    unsigned char height = edl->metadata.height;
+    unsigned char width = edl->metadata.width;
+    unsigned char targetWidth, targetHeight;
+    if ((float)width / height > targetAspectRatio) {
+        targetHeight = height;
+        targetWidth = (unsigned char)(height * targetAspectRatio);
+    } else {
+        targetWidth = width;
+        targetHeight = (unsigned char)(width / targetAspectRatio);
+    }
+
+    // Crop windows nest, so only the offsets accumulate
+    for (int i = 0; i < edl->numSegments; i++) {
+        edl->segments[i].cropTop += (height - targetHeight) / 2;
+        edl->segments[i].cropLeft += (width - targetWidth) / 2;
+    }
+    edl->metadata.height = targetHeight;
+    edl->metadata.width = targetWidth;
+    return 0;
+}
+
+int edl_load(EditList *edl, FILE *edlFile) {
+    char line[MAX_EDL_LINE];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), edlFile)) {
+        lineNumber++;
+        if (!strchr(line, '\n') && !feof(edlFile)) {
+            fprintf(stderr, "Error: Line %d is longer than %d characters\n",
+                lineNumber, MAX_EDL_LINE - 2);
+            return -1;
+        }
+        // Tokens are separated by at least one character, so a whole line
+        // of them always fits
+        char *tokens[MAX_EDL_LINE / 2];
+        int numTokens = 0;
+        for (char *token = strtok(line, " \t\r\n"); token;
+                token = strtok(NULL, " \t\r\n")) {
+            tokens[numTokens++] = token;
+        }
+        // Blank lines and comments
+        if (numTokens == 0 || tokens[0][0] == '#') continue;
+
+        const char *operation = tokens[0];
+        char **params = &tokens[1];
+        int paramCount = numTokens - 1;
+        int status = -1;
+        unsigned char ch1, ch2, min, max;
+        if (strcmp(operation, "reverse") == 0 && paramCount == 0) {
+            status = edl_reverse(edl);
+        } else if (strcmp(operation, "speed_up") == 0 && paramCount == 1) {
+            status = edl_speed_up(edl, atoi(params[0]));
+        } else if (strcmp(operation, "trim") == 0 && paramCount == 2) {
+            status = edl_trim(edl, atoll(params[0]), atoll(params[1]));
+        } else if (strcmp(operation, "concat") == 0 && paramCount >= 1) {
+            // Stop at the first clip that cannot be joined
+            status = 0;
+            for (int i = 0; i < paramCount && status == 0; i++) {
+                status = edl_concat(edl, params[i]);
+            }
+        } else if (strcmp(operation, "swap_channel") == 0 && paramCount == 1
+                && sscanf(params[0], "%hhu,%hhu", &ch1, &ch2) == 2) {
+            status = edl_swap_channel(edl, ch1, ch2);
+        } else if (strcmp(operation, "clip_channel") == 0 && paramCount == 2
+                && sscanf(params[1], "[%hhu,%hhu]", &min, &max) == 2) {
+            status = edl_clip_channel(edl, (unsigned char)atoi(params[0]),
+                min, max);
+        } else if (strcmp(operation, "scale_channel") == 0
+                && paramCount == 2) {
+            status = edl_scale_channel(edl, (unsigned char)atoi(params[0]),
+                atof(params[1]));
+        } else if (strcmp(operation, "crop_aspect") == 0 && paramCount == 1) {
+            status = edl_crop_aspect(edl, params[0]);
+        } else {
+            fprintf(stderr, "Error: Invalid edit on line %d: %s\n",
+                lineNumber, operation);
+        }
+        if (status != 0) return -1;
+    }
+    return 0;
+}
+
+// Read one source frame, with pread where there is a descriptor so the
+// shared stdio position is left alone
+static void read_source_frame(const EditSource *source, int64_t frame,
+        unsigned char *buffer) {
+    size_t frameSize = frame_size(&source->metadata);
+    off_t offset = sizeof(VideoMetadata) + frame * frameSize;
+    int fd = fileno(source->file);
+    if (fd != -1) {
+        if (pread(fd, buffer, frameSize, offset) == (ssize_t)frameSize) {
+            return;
+        }
+    } else if (fseeko(source->file, offset, SEEK_SET) == 0
+            && fread(buffer, 1, frameSize, source->file) == frameSize) {
+        return;
+    }
+    perror("Error reading frame data");
+    exit(1);
+}
+
+static bool is_identity(const EditSegment *segment,
+        const VideoMetadata *source, const VideoMetadata *output) {
+    if (source->height != output->height || source->width != output->width) {
+        return false;
+    }
+    for (int ch = 0; ch < output->channels; ch++) {
+        if (segment->sourceChannel[ch] != ch) return false;
+        for (int value = 0; value < 256; value++) {
+            if (segment->lookupTables[ch][value] != value) return false;
+        }
+    }
+    return true;
+}
+
+// Crop, channel remap and lookup table in a single pass over the frame
+static void transform_frame(const EditSegment *segment,
+        const VideoMetadata *source, const VideoMetadata *output,
+        const unsigned char *src, unsigned char *dst) {
+    size_t sourcePlane = source->height * source->width;
+    size_t outputPlane = output->height * output->width;
+    for (int ch = 0; ch < output->channels; ch++) {
+        const unsigned char *plane = src
+            + segment->sourceChannel[ch] * sourcePlane
+            + segment->cropTop * source->width + segment->cropLeft;
+        unsigned char *planeOut = dst + ch * outputPlane;
+        if (source->width == output->width) {
+            // Rows are contiguous without a horizontal crop
+            apply_lut(plane, planeOut, outputPlane,
+                segment->lookupTables[ch]);
+            continue;
+        }
+        for (int row = 0; row < output->height; row++) {
+            apply_lut(plane + row * source->width,
+                planeOut + row * output->width, output->width,
+                segment->lookupTables[ch]);
+        }
+    }
+}
+
+void edl_render(EditList *edl, FILE *outputFile) {
+    int64_t numFrames = edl_num_frames(edl);
+    size_t frameSize = frame_size(&edl->metadata);
+    size_t sourceFrameSize = 0;
+    for (int i = 0; i < edl->numSources; i++) {
+        size_t size = frame_size(&edl->sources[i].metadata);
+        if (size > sourceFrameSize) sourceFrameSize = size;
+    }
+
+    bool *identity = malloc(edl->numSegments * sizeof(bool));
+    unsigned char *batch = pool_acquire(BATCH_SIZE * frameSize);
+    unsigned char *sourceBatch = pool_acquire(BATCH_SIZE * sourceFrameSize);
+    // Output frame to segment and source frame, filled per batch
+    int *frameSegment = malloc(BATCH_SIZE * sizeof(int));
+    if (!identity || !batch || !sourceBatch || !frameSegment) {
+        perror("Error allocating memory");
+        free(identity);
+        pool_release(batch);
+        pool_release(sourceBatch);
+        free(frameSegment);
+        exit(1);
+    }
+    for (int i = 0; i < edl->numSegments; i++) {
+        EditSegment *segment = &edl->segments[i];
+        identity[i] = is_identity(segment,
+            &edl->sources[segment->source].metadata, &edl->metadata);
+    }
+
+    update_metadata(outputFile, numFrames, edl->metadata.height,
+        edl->metadata.width);
+
+    int segmentIndex = 0;
+    int64_t local = 0;
+    for (int64_t batchStart = 0; batchStart < numFrames;
+            batchStart += BATCH_SIZE) {
+        int framesInBatch = numFrames - batchStart < BATCH_SIZE
+                          ? numFrames - batchStart : BATCH_SIZE;
+
+        // Only the source frames the output uses are read, straight into
+        // the output batch when the segment has no pixel transform
+        for (int i = 0; i < framesInBatch; i++) {
+            while (local == edl->segments[segmentIndex].count) {
+                segmentIndex++;
+                local = 0;
+            }
+            EditSegment *segment = &edl->segments[segmentIndex];
+            unsigned char *buffer = identity[segmentIndex]
+                                  ? batch + i * frameSize
+                                  : sourceBatch + i * sourceFrameSize;
+            read_source_frame(&edl->sources[segment->source],
+                segment->start + local * segment->step, buffer);
+            frameSegment[i] = segmentIndex;
+            local++;
+        }
+
+        #pragma omp parallel for
+        for (int i = 0; i < framesInBatch; i++) {
+            if (identity[frameSegment[i]]) continue;
+            EditSegment *segment = &edl->segments[frameSegment[i]];
+            transform_frame(segment, &edl->sources[segment->source].metadata,
+                &edl->metadata, sourceBatch + i * sourceFrameSize,
+                batch + i * frameSize);
+        }
+
+        if (fwrite(batch, frameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            free(identity);
+            pool_release(batch);
+            pool_release(sourceBatch);
+            free(frameSegment);
+            exit(1);
+        }
+    }
+
+    free(identity);
+    pool_release(batch);
+    pool_release(sourceBatch);
+    free(frameSegment);
+    printf("Render completed successfully. %ld frames from %d segments.\n",
+        numFrames, edl->numSegments);
+}
@@ -0,0 +1,32 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_EDL_H
+#define LIB_FILMMASTER2000_EDL_H
+#include <stdio.h>
+#include <stdint.h>
+#include "film_library.h"
+
+// Edit decision list. Operations only update a description of the output,
+// no frame is read until edl_render. The edit functions return 0 on
+// success and -1 after printing an error for invalid parameters, or for
+// a clip that cannot be opened or joined.
+typedef struct EditList EditList;
+
+// The source file is borrowed and must stay open until edl_free
+EditList *edl_create(FILE *source, const VideoMetadata *metadata);
+void edl_free(EditList *edl);
+int64_t edl_num_frames(const EditList *edl);
+
+int edl_reverse(EditList *edl);
+int edl_speed_up(EditList *edl, int speedFactor);
+int edl_trim(EditList *edl, int64_t start, int64_t end);
+int edl_concat(EditList *edl, const char *clipPath);
+int edl_swap_channel(EditList *edl, unsigned char ch1, unsigned char ch2);
+int edl_clip_channel(EditList *edl, unsigned char channel,
+    unsigned char min, unsigned char max);
+int edl_scale_channel(EditList *edl, unsigned char channel, float factor);
+int edl_crop_aspect(EditList *edl, const char *aspectRatioStr);
+
+// Applies one operation per line, written as on the runme command line
+int edl_load(EditList *edl, FILE *edlFile);
+void edl_render(EditList *edl, FILE *outputFile);
+#endif
@@ -0,0 +1,552 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for malloc, free
+#include <string.h>  // for memcpy, memset, strcmp
+#include <math.h>  // for expf, ceilf
+#include <omp.h>  // for OpenMP parallelization
+#include <immintrin.h>  // for AVX2 intrinsics SIMD
+#include <stdint.h>  // for int64_t type
+#include <stdbool.h>  // for boolean type
+#include "film_library_simd.h"  // for simd_level
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_filter.h"
+
+#define MAX_FILTER_RADIUS 32
+// Strip of intermediate rows kept hot between the two passes
+#define FILTER_STRIP_BYTES (32 * 1024)
+#define SHARPEN_SIGMA 1.0f
+
+// Separable kernel in 16-bit fixed point. Horizontal taps sum to 256,
+// so the intermediate rows carry 8 fractional bits. Vertical taps sum to
+// 65535 and are applied with a high-half multiply.
+typedef struct {
+    int radius;
+    uint16_t horizontal[2 * MAX_FILTER_RADIUS + 1];
+    uint16_t vertical[2 * MAX_FILTER_RADIUS + 1];
+} SeparableKernel;
+
+// Quantise weights so they sum to exactly total, fixing rounding on the centre
+static void quantise_taps(const float *weights, int taps,
+        uint16_t *out, int total) {
+    int sum = 0;
+    for (int k = 0; k < taps; k++) {
+        out[k] = (uint16_t)(weights[k] * total + 0.5f);
+        sum += out[k];
+    }
+    out[taps / 2] = (uint16_t)(out[taps / 2] + total - sum);
+}
+
+static void build_gaussian_kernel(SeparableKernel *kernel, float sigma) {
+    int radius = (int)ceilf(3.0f * sigma);
+    if (radius > MAX_FILTER_RADIUS) radius = MAX_FILTER_RADIUS;
+    int taps = 2 * radius + 1;
+
+    float weights[2 * MAX_FILTER_RADIUS + 1];
+    float sum = 0;
+    for (int k = -radius; k <= radius; k++) {
+        weights[k + radius] = expf(-(k * k) / (2.0f * sigma * sigma));
+        sum += weights[k + radius];
+    }
+    for (int k = 0; k < taps; k++) {
+        weights[k] /= sum;
+    }
+
+    kernel->radius = radius;
+    quantise_taps(weights, taps, kernel->horizontal, 256);
+    quantise_taps(weights, taps, kernel->vertical, 65535);
+}
+
+TARGET_AVX2
+static int convolve_row_avx2(const unsigned char *padded, uint16_t *out,
+        int width, const SeparableKernel *kernel) {
+    int taps = 2 * kernel->radius + 1;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i acc = _mm256_setzero_si256();
+        for (int k = 0; k < taps; k++) {
+            __m256i pixels = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128((const __m128i *)(padded + x + k)));
+            acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(pixels,
+                _mm256_set1_epi16((int16_t)kernel->horizontal[k])));
+        }
+        _mm256_storeu_si256((__m256i *)(out + x), acc);
+    }
+    return x;
+}
+
+// One row: 8-bit padded input to 16-bit output with 8 fractional bits
+static void convolve_row(const unsigned char *padded, uint16_t *out,
+        int width, const SeparableKernel *kernel) {
+    int taps = 2 * kernel->radius + 1;
+    int x = 0;
+    if (simd_level() >= SIMD_AVX2) {
+        x = convolve_row_avx2(padded, out, width, kernel);
+    }
+    for (; x < width; x++) {
+        uint32_t acc = 0;
+        for (int k = 0; k < taps; k++) {
+            acc += padded[x + k] * kernel->horizontal[k];
+        }
+        out[x] = (uint16_t)acc;
+    }
+}
+
+TARGET_AVX2
+static int convolve_column_avx2(uint16_t *const *rows, unsigned char *out,
+        int width, const SeparableKernel *kernel) {
+    int taps = 2 * kernel->radius + 1;
+    int x = 0;
+    __m256i round = _mm256_set1_epi16(128);
+    for (; x + 32 <= width; x += 32) {
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        for (int k = 0; k < taps; k++) {
+            __m256i weight = _mm256_set1_epi16((int16_t)kernel->vertical[k]);
+            acc0 = _mm256_add_epi16(acc0, _mm256_mulhi_epu16(
+                _mm256_loadu_si256((const __m256i *)(rows[k] + x)), weight));
+            acc1 = _mm256_add_epi16(acc1, _mm256_mulhi_epu16(
+                _mm256_loadu_si256((const __m256i *)(rows[k] + x + 16)),
+                weight));
+        }
+        acc0 = _mm256_srli_epi16(_mm256_adds_epu16(acc0, round), 8);
+        acc1 = _mm256_srli_epi16(_mm256_adds_epu16(acc1, round), 8);
+        // packus works per 128-bit lane, so restore the element order
+        __m256i packed = _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(acc0, acc1), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(out + x), packed);
+    }
+    return x;
+}
+
+// One column pass over taps consecutive intermediate rows back to 8 bits
+static void convolve_column(uint16_t *const *rows, unsigned char *out,
+        int width, const SeparableKernel *kernel) {
+    int taps = 2 * kernel->radius + 1;
+    int x = 0;
+    if (simd_level() >= SIMD_AVX2) {
+        x = convolve_column_avx2(rows, out, width, kernel);
+    }
+    for (; x < width; x++) {
+        uint32_t acc = 0;
+        for (int k = 0; k < taps; k++) {
+            acc += (rows[k][x] * (uint32_t)kernel->vertical[k]) >> 16;
+        }
+        acc += 128;
+        out[x] = (unsigned char)((acc > 65535 ? 65535 : acc) >> 8);
+    }
+}
+
+// Per-thread scratch, allocated once and reused for every frame
+typedef struct {
+    unsigned char *padded;  // one row with clamped edges
+    uint16_t *strip;  // horizontally filtered rows plus vertical halo
+    int stripRows;
+} FilterScratch;
+
+// Blur one plane in horizontal strips so the intermediate stays in L1
+static void blur_plane(const unsigned char *src, unsigned char *dst,
+        int height, int width, const SeparableKernel *kernel,
+        FilterScratch *scratch) {
+    int radius = kernel->radius;
+    uint16_t *rows[2 * MAX_FILTER_RADIUS + 1];
+
+    for (int stripStart = 0; stripStart < height;
+            stripStart += scratch->stripRows) {
+        int stripEnd = stripStart + scratch->stripRows;
+        if (stripEnd > height) stripEnd = height;
+
+        // Horizontal pass over the strip and its halo, clamping at edges
+        for (int r = 0; r < stripEnd - stripStart + 2 * radius; r++) {
+            int y = stripStart - radius + r;
+            if (y < 0) y = 0;
+            if (y > height - 1) y = height - 1;
+            const unsigned char *row = src + y * width;
+            memset(scratch->padded, row[0], radius);
+            memcpy(scratch->padded + radius, row, width);
+            memset(scratch->padded + radius + width, row[width - 1], radius);
+            convolve_row(scratch->padded, scratch->strip + r * width,
+                width, kernel);
+        }
+
+        // Vertical pass reads the halo rows directly from the strip
+        for (int y = stripStart; y < stripEnd; y++) {
+            for (int k = 0; k <= 2 * radius; k++) {
+                rows[k] = scratch->strip + (y - stripStart + k) * width;
+            }
+            convolve_column(rows, dst + y * width, width, kernel);
+        }
+    }
+}
+
+// Unsharp mask: dst = src + amount * (src - blurred), amount in Q8
+static void sharpen_plane(const unsigned char *src, unsigned char *dst,
+        size_t planeSize, int amount) {
+    for (size_t pixel = 0; pixel < planeSize; pixel++) {
+        int detail = src[pixel] - dst[pixel];
+        int value = src[pixel] + ((detail * amount + 128) >> 8);
+        dst[pixel] = (unsigned char)(value < 0 ? 0 :
+                                     value > 255 ? 255 : value);
+    }
+}
+
+void filter_video(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        const char *filterType, float strength) {
+    bool sharpen;
+    SeparableKernel kernel = {0};
+
+    if (strcmp(filterType, "gaussian") == 0) {
+        if (strength <= 0 || strength > MAX_FILTER_RADIUS / 3.0f) {
+            fprintf(stderr, "Error: Gaussian sigma must be in (0, %.1f].\n",
+                MAX_FILTER_RADIUS / 3.0f);
+            exit(1);
+        }
+        sharpen = false;
+        build_gaussian_kernel(&kernel, strength);
+    } else if (strcmp(filterType, "sharpen") == 0) {
+        if (strength <= 0 || strength > 8) {
+            fprintf(stderr, "Error: Sharpen amount must be in (0, 8].\n");
+            exit(1);
+        }
+        sharpen = true;
+        build_gaussian_kernel(&kernel, SHARPEN_SIGMA);
+    } else {
+        fprintf(stderr, "Error: Unknown filter %s. "
+            "Use gaussian or sharpen.\n", filterType);
+        exit(1);
+    }
+
+    size_t planeSize = height * width;
+    size_t frameSize = planeSize * channels;
+    size_t batchSize = 256;  // Number of frames per batch
+    int numThreads = omp_get_max_threads();
+
+    // Strip height so that the intermediate rows fit the strip budget
+    int stripRows = FILTER_STRIP_BYTES / (width * sizeof(uint16_t))
+                    - 2 * kernel.radius;
+    if (stripRows < 8) stripRows = 8;
+    if (stripRows > height) stripRows = height;
+    size_t stripSize = (stripRows + 2 * kernel.radius) * width;
+
+    unsigned char *inBatch = pool_acquire(batchSize * frameSize);
+    unsigned char *outBatch = pool_acquire(batchSize * frameSize);
+    FilterScratch *scratch = malloc(numThreads * sizeof(FilterScratch));
+    unsigned char *paddedRows = pool_acquire(numThreads *
+                                       (width + 2 * kernel.radius));
+    uint16_t *strips = pool_acquire(numThreads * stripSize * sizeof(uint16_t));
+
+    if (!inBatch || !outBatch || !scratch || !paddedRows || !strips) {
+        perror("Error allocating memory");
+        pool_release(inBatch);
+        pool_release(outBatch);
+        free(scratch);
+        pool_release(paddedRows);
+        pool_release(strips);
+        exit(1);
+    }
+
+    for (int t = 0; t < numThreads; t++) {
+        scratch[t].padded = paddedRows + t * (width + 2 * kernel.radius);
+        scratch[t].strip = strips + t * stripSize;
+        scratch[t].stripRows = stripRows;
+    }
+
+    int amount = (int)(strength * 256 + 0.5f);
+
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(inBatch, frameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            free(scratch);
+            pool_release(paddedRows);
+            pool_release(strips);
+            exit(1);
+        }
+
+        // Each thread filters whole frames with its own scratch buffers
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            FilterScratch *threadScratch = &scratch[omp_get_thread_num()];
+            for (unsigned char ch = 0; ch < channels; ch++) {
+                size_t offset = frame * frameSize + ch * planeSize;
+                blur_plane(inBatch + offset, outBatch + offset,
+                    height, width, &kernel, threadScratch);
+                if (sharpen) {
+                    sharpen_plane(inBatch + offset, outBatch + offset,
+                        planeSize, amount);
+                }
+            }
+        }
+
+        if (fwrite(outBatch, frameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            free(scratch);
+            pool_release(paddedRows);
+            pool_release(strips);
+            exit(1);
+        }
+    }
+
+    pool_release(inBatch);
+    pool_release(outBatch);
+    free(scratch);
+    pool_release(paddedRows);
+    pool_release(strips);
+    printf("Filter %s completed successfully.\n", filterType);
+}
+
+#define MAX_TEMPORAL_RADIUS 16
+
+TARGET_AVX2
+static size_t update_window_sums_avx2(uint16_t *sums,
+        const unsigned char *entering, const unsigned char *leaving,
+        size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m256i in = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(entering + i)));
+        __m256i out = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(leaving + i)));
+        __m256i sum = _mm256_loadu_si256((const __m256i *)(sums + i));
+        sum = _mm256_sub_epi16(_mm256_add_epi16(sum, in), out);
+        _mm256_storeu_si256((__m256i *)(sums + i), sum);
+    }
+    return i;
+}
+
+// sums[i] += entering[i] - leaving[i] for the sliding window total
+static void update_window_sums(uint16_t *sums, const unsigned char *entering,
+        const unsigned char *leaving, size_t size) {
+    size_t i = 0;
+    if (simd_level() >= SIMD_AVX2) {
+        i = update_window_sums_avx2(sums, entering, leaving, size);
+    }
+    for (; i < size; i++) {
+        sums[i] = (uint16_t)(sums[i] + entering[i] - leaving[i]);
+    }
+}
+
+TARGET_AVX2
+static size_t window_mean_avx2(const uint16_t *sums, unsigned char *out,
+        size_t size, uint16_t reciprocal, int shift, uint16_t half) {
+    size_t i = 0;
+    __m256i vReciprocal = _mm256_set1_epi16((int16_t)reciprocal);
+    __m256i vHalf = _mm256_set1_epi16((int16_t)half);
+    __m128i vShift = _mm_cvtsi32_si128(shift);
+    for (; i + 32 <= size; i += 32) {
+        __m256i lo = _mm256_loadu_si256((const __m256i *)(sums + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i *)(sums + i + 16));
+        lo = _mm256_srl_epi16(_mm256_mulhi_epu16(
+            _mm256_add_epi16(lo, vHalf), vReciprocal), vShift);
+        hi = _mm256_srl_epi16(_mm256_mulhi_epu16(
+            _mm256_add_epi16(hi, vHalf), vReciprocal), vShift);
+        __m256i packed = _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(out + i), packed);
+    }
+    return i;
+}
+
+// out[i] = round(sums[i] / windowSize), which for an odd windowSize is
+// floor((sums[i] + half) / windowSize), as a 16-bit multiply-high and a
+// shift. With 2^shift < windowSize < 2^(shift + 1) the reciprocal
+// ceil(2^(16 + shift) / windowSize) fits in 16 bits, and its error times
+// any dividend up to 256 * windowSize stays below 2^(16 + shift) for
+// windows under 128 frames, so every quotient is exact.
+static void window_mean(const uint16_t *sums, unsigned char *out,
+        size_t size, int windowSize) {
+    int shift = 0;
+    while ((2 << shift) <= windowSize) shift++;
+    uint32_t scale = (uint32_t)1 << (16 + shift);
+    uint16_t reciprocal = (uint16_t)((scale + windowSize - 1) / windowSize);
+    uint16_t half = (uint16_t)(windowSize / 2);
+    size_t i = 0;
+    if (simd_level() >= SIMD_AVX2) {
+        i = window_mean_avx2(sums, out, size, reciprocal, shift, half);
+    }
+    for (; i < size; i++) {
+        uint32_t value = ((uint32_t)(sums[i] + half) * reciprocal)
+                       >> (16 + shift);
+        out[i] = (unsigned char)(value > 255 ? 255 : value);
+    }
+}
+
+// Median of pixels [i, end) in 32-byte blocks, returns where it stopped
+TARGET_AVX2
+static size_t window_median_avx2(unsigned char *const *window,
+        unsigned char *out, size_t i, size_t end, int windowSize) {
+    __m256i values[2 * MAX_TEMPORAL_RADIUS + 1];
+    for (; i + 32 <= end; i += 32) {
+        for (int k = 0; k < windowSize; k++) {
+            values[k] = _mm256_loadu_si256((const __m256i *)(window[k] + i));
+        }
+        for (int pass = 0; pass < windowSize; pass++) {
+            for (int k = pass & 1; k + 1 < windowSize; k += 2) {
+                __m256i low = _mm256_min_epu8(values[k], values[k + 1]);
+                values[k + 1] = _mm256_max_epu8(values[k], values[k + 1]);
+                values[k] = low;
+            }
+        }
+        _mm256_storeu_si256((__m256i *)(out + i), values[windowSize / 2]);
+    }
+    return i;
+}
+
+// Per-pixel median of windowSize frames with an odd-even transposition sort
+static void window_median(unsigned char *const *window, unsigned char *out,
+        size_t size, int windowSize) {
+    bool vector = simd_level() >= SIMD_AVX2;
+    #pragma omp parallel for schedule(static)
+    for (size_t chunk = 0; chunk < size; chunk += 1024) {
+        size_t end = chunk + 1024 < size ? chunk + 1024 : size;
+        size_t i = chunk;
+        if (vector) i = window_median_avx2(window, out, i, end, windowSize);
+        unsigned char pixels[2 * MAX_TEMPORAL_RADIUS + 1] = {0};
+        for (; i < end; i++) {
+            // Insertion sort, the window is small
+            for (int k = 0; k < windowSize; k++) {
+                unsigned char value = window[k][i];
+                int j = k;
+                while (j > 0 && pixels[j - 1] > value) {
+                    pixels[j] = pixels[j - 1];
+                    j--;
+                }
+                pixels[j] = value;
+            }
+            out[i] = pixels[windowSize / 2];
+        }
+    }
+}
+
+// Frames outside the file repeat the first or last frame
+static int64_t clamp_frame(int64_t numFrames, int64_t frame) {
+    if (frame < 0) return 0;
+    if (frame > numFrames - 1) return numFrames - 1;
+    return frame;
+}
+
+static unsigned char *ring_slot(unsigned char *ring, int64_t frame,
+        int windowSize, size_t frameSize) {
+    return ring + (frame % windowSize) * frameSize;
+}
+
+void temporal_denoise(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        int radius, const char *method) {
+    if (radius < 1 || radius > MAX_TEMPORAL_RADIUS) {
+        fprintf(stderr, "Error: Temporal radius must be in [1, %d].\n",
+            MAX_TEMPORAL_RADIUS);
+        exit(1);
+    }
+
+    bool median = false;
+    if (method != NULL) {
+        if (strcmp(method, "median") == 0) {
+            median = true;
+        } else if (strcmp(method, "mean") != 0) {
+            fprintf(stderr, "Error: Unknown denoise method %s. "
+                "Use mean or median.\n", method);
+            exit(1);
+        }
+    }
+    if (numFrames <= 0) return;
+
+    size_t frameSize = height * width * channels;
+    int windowSize = 2 * radius + 1;
+
+    // Ring buffer holding frames i - radius .. i + radius, slot j % windowSize
+    unsigned char *ring = pool_acquire(windowSize * frameSize);
+    unsigned char *outFrame = pool_acquire(frameSize);
+    uint16_t *sums = pool_acquire(frameSize * sizeof(uint16_t));
+    if (!ring || !outFrame || !sums) {
+        perror("Error allocating memory");
+        pool_release(ring);
+        pool_release(outFrame);
+        pool_release(sums);
+        exit(1);
+    }
+    memset(sums, 0, frameSize * sizeof(uint16_t));
+
+    int64_t lastLoaded = -1;
+    unsigned char *window[2 * MAX_TEMPORAL_RADIUS + 1];
+
+    // Fill the window around frame 0
+    for (int64_t frame = -radius; frame <= radius; frame++) {
+        int64_t source = clamp_frame(numFrames, frame);
+        unsigned char *slot = ring_slot(ring, source, windowSize, frameSize);
+        if (source > lastLoaded) {
+            if (fread(slot, 1, frameSize, inputFile) != frameSize) {
+                perror("Error reading frame data");
+                pool_release(ring);
+                pool_release(outFrame);
+                pool_release(sums);
+                exit(1);
+            }
+            lastLoaded = source;
+        }
+        if (!median) {
+            for (size_t i = 0; i < frameSize; i++) {
+                sums[i] = (uint16_t)(sums[i] + slot[i]);
+            }
+        }
+    }
+
+    for (int64_t frame = 0; frame < numFrames; frame++) {
+        if (median) {
+            for (int k = 0; k < windowSize; k++) {
+                window[k] = ring_slot(ring,
+                    clamp_frame(numFrames, frame - radius + k),
+                    windowSize, frameSize);
+            }
+            window_median(window, outFrame, frameSize, windowSize);
+        } else {
+            window_mean(sums, outFrame, frameSize, windowSize);
+        }
+
+        if (fwrite(outFrame, 1, frameSize, outputFile) != frameSize) {
+            perror("Error writing frame data");
+            pool_release(ring);
+            pool_release(outFrame);
+            pool_release(sums);
+            exit(1);
+        }
+
+        // Slide the window. The entering frame reuses the leaving frame's
+        // slot, so keep a copy of the leaving frame in the spent output buffer
+        int64_t leaving = clamp_frame(numFrames, frame - radius);
+        int64_t entering = clamp_frame(numFrames, frame + radius + 1);
+        unsigned char *slot = ring_slot(ring, entering, windowSize, frameSize);
+        if (!median) {
+            memcpy(outFrame, ring_slot(ring, leaving, windowSize, frameSize),
+                frameSize);
+        }
+        if (entering > lastLoaded) {
+            if (fread(slot, 1, frameSize, inputFile) != frameSize) {
+                perror("Error reading frame data");
+                pool_release(ring);
+                pool_release(outFrame);
+                pool_release(sums);
+                exit(1);
+            }
+            lastLoaded = entering;
+        }
+        if (!median) {
+            update_window_sums(sums, slot, outFrame, frameSize);
+        }
+    }
+
+    pool_release(ring);
+    pool_release(outFrame);
+    pool_release(sums);
+    printf("Temporal denoise completed successfully.\n");
+}
@@ -0,0 +1,13 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_FILTER_H
+#define LIB_FILMMASTER2000_FILTER_H
+#include <stdio.h>
+#include <stdint.h>
+
+void filter_video(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        const char *filterType, float strength);
+void temporal_denoise(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        int radius, const char *method);
+#endif
@@ -0,0 +1,172 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for exit
+#include <omp.h>  // for OpenMP parallelization
+#include <stdint.h>  // for int64_t type
+#include <stdbool.h>  // for boolean type
+#include "film_library.h"  // for VideoMetadata and FORMAT_PACKED
+#include "film_library_simd.h"  // for the packed and layout kernels
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_layout.h"
+
+typedef enum {
+    PACK,
+    UNPACK,
+    SWAP,
+    CLIP,
+    SCALE
+} LayoutOperation;
+
+typedef struct {
+    LayoutOperation operation;
+    int channel1;
+    int channel2;
+    unsigned char min;
+    unsigned char max;
+    float factor;
+} LayoutJob;
+
+// Channel operations change the frame in place, conversions write to dst
+static void apply_frame(const LayoutJob *job, unsigned char *src,
+        unsigned char *dst, size_t planeSize, int channels) {
+    switch (job->operation) {
+    case PACK:
+        pack_planes(src, planeSize, channels, dst);
+        break;
+    case UNPACK:
+        unpack_pixels(src, planeSize, channels, dst);
+        break;
+    case SWAP:
+        swap_packed(src, planeSize, channels, job->channel1, job->channel2);
+        break;
+    case CLIP:
+        clip_packed(src, planeSize, channels, job->channel1, job->min,
+                    job->max);
+        break;
+    case SCALE:
+        scale_packed(src, planeSize, channels, job->channel1, job->factor);
+        break;
+    }
+}
+
+static void layout_video(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *metadata, const LayoutJob *job) {
+    bool converts = job->operation == PACK || job->operation == UNPACK;
+    size_t planeSize = metadata->height * metadata->width;
+    size_t frameSize = planeSize * metadata->channels;
+    size_t batchSize = 256;  // Number of frames per batch
+    unsigned char *inBatch = pool_acquire(batchSize * frameSize);
+    unsigned char *outBatch = converts ? pool_acquire(batchSize * frameSize)
+                                       : inBatch;
+    if (!inBatch || !outBatch) {
+        perror("Error allocating memory");
+        pool_release(inBatch);
+        if (converts) pool_release(outBatch);
+        exit(1);
+    }
+
+    if (converts) {
+        // Only the layout bit changes, written before any frames
+        VideoMetadata header = *metadata;
+        header.format ^= FORMAT_PACKED;
+        fseek(outputFile, 0, SEEK_SET);
+        if (fwrite(&header, sizeof(VideoMetadata), 1, outputFile) != 1) {
+            perror("Error writing metadata");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            exit(1);
+        }
+    }
+
+    for (int64_t framesProcessed = 0; framesProcessed < metadata->numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = metadata->numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(inBatch, frameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(inBatch);
+            if (converts) pool_release(outBatch);
+            exit(1);
+        }
+
+        // Frames are independent, so split the batch across threads
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            apply_frame(job, inBatch + frame * frameSize,
+                        outBatch + frame * frameSize, planeSize,
+                        metadata->channels);
+        }
+
+        if (fwrite(outBatch, frameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            pool_release(inBatch);
+            if (converts) pool_release(outBatch);
+            exit(1);
+        }
+    }
+
+    pool_release(inBatch);
+    if (converts) pool_release(outBatch);
+}
+
+void to_packed(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *inputMetadata) {
+    if (inputMetadata->format & FORMAT_PACKED) {
+        fprintf(stderr, "Error: Input is already packed.\n");
+        exit(1);
+    }
+    LayoutJob job = {.operation = PACK};
+    layout_video(inputFile, outputFile, inputMetadata, &job);
+    printf("Frames packed to %dx%dx%d pixels.\n", inputMetadata->height,
+        inputMetadata->width, inputMetadata->channels);
+}
+
+void to_planar(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *inputMetadata) {
+    if (!(inputMetadata->format & FORMAT_PACKED)) {
+        fprintf(stderr, "Error: Input is already planar.\n");
+        exit(1);
+    }
+    LayoutJob job = {.operation = UNPACK};
+    layout_video(inputFile, outputFile, inputMetadata, &job);
+    printf("Frames split into %d planes.\n", inputMetadata->channels);
+}
+
+void swap_channel_packed(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *metadata, unsigned char channel1,
+        unsigned char channel2) {
+    if (channel1 >= metadata->channels || channel2 >= metadata->channels) {
+        fprintf(stderr, "Error: Invalid channel index\n");
+        exit(1);
+    }
+    LayoutJob job = {.operation = SWAP, .channel1 = channel1,
+        .channel2 = channel2};
+    layout_video(inputFile, outputFile, metadata, &job);
+}
+
+void clip_channel_packed(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *metadata, unsigned char channel,
+        unsigned char min, unsigned char max) {
+    if (channel >= metadata->channels) {
+        fprintf(stderr, "Error: Invalid channel index\n");
+        exit(1);
+    }
+    LayoutJob job = {.operation = CLIP, .channel1 = channel, .min = min,
+        .max = max};
+    layout_video(inputFile, outputFile, metadata, &job);
+}
+
+void scale_channel_packed(FILE *inputFile, FILE *outputFile,
+        const VideoMetadata *metadata, unsigned char channel, float factor) {
+    if (channel >= metadata->channels) {
+        fprintf(stderr, "Error: Invalid channel index\n");
+        exit(1);
+    }
+    LayoutJob job = {.operation = SCALE, .channel1 = channel,
+        .factor = factor};
+    layout_video(inputFile, outputFile, metadata, &job);
+}
@@ -0,0 +1,23 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_LAYOUT_H
+#define LIB_FILMMASTER2000_LAYOUT_H
+#include <stdio.h>
+#include <stdint.h>
+#include "film_library.h"
+
+// Planar frames to height x width x channels pixels, sets FORMAT_PACKED
+void to_packed(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *inputMetadata);
+// Packed pixels back to one plane per channel
+void to_planar(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *inputMetadata);
+// Channel operations on packed frames, without converting them
+void swap_channel_packed(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *metadata, unsigned char channel1,
+    unsigned char channel2);
+void clip_channel_packed(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *metadata, unsigned char channel,
+    unsigned char min, unsigned char max);
+void scale_channel_packed(FILE *inputFile, FILE *outputFile,
+    const VideoMetadata *metadata, unsigned char channel, float factor);
+#endif
@@ -2,9 +2,21 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>  // for memset, strcmp
+#include <stdbool.h>  // for boolean type
+#include <omp.h>  // for OpenMP parallelization
+#include <immintrin.h>  // for AVX2 intrinsics SIMD
+#include "film_library.h"  // for update_metadata
+#include "film_library_colour.h"  // for downsample_2x2
+#include "film_library_simd.h"  // for simd_level and copy_rows
+#include "film_library_pool.h"  // for pool_acquire, pool_release
 #include "film_library_plus.h"
 #include <stdint.h>
 
+int64_t speed_up_frames(int64_t numFrames, int speedFactor) {
+    return (numFrames + speedFactor - 1) / speedFactor;
+}
+
 void speed_up(FILE *inputFile, FILE *outputFile, int64_t numFrames,
         unsigned char height, unsigned char width,
         unsigned char channels, int speedFactor) {
@@ -14,33 +26,23 @@ void speed_up(FILE *inputFile, FILE *outputFile, int64_t numFrames,
     }
 
     size_t frameSize = height * width * channels;
-    unsigned char *frameBuffer = malloc(frameSize);
+    unsigned char *frameBuffer = pool_acquire(frameSize);
     if (!frameBuffer) {
         perror("Error allocating memory");
         exit(1);
     }
 
     // Calculate the new frame count after fast forwarding
-    int64_t newFrameCount = numFrames / speedFactor;
+    int64_t newFrameCount = speed_up_frames(numFrames, speedFactor);
 
     // Write the updated metadata with the new frame count
-    #pragma pack(1)  // No padding
-    typedef struct {
-        int64_t numFrames;       // 8 bytes
-        unsigned char channels;  // 1 byte
-        unsigned char height;    // 1 byte
-        unsigned char width;     // 1 byte
-    } VideoMetadata;
-    #pragma pack()
-    VideoMetadata metadata = {newFrameCount, channels, height, width};
-    fseek(outputFile, 0, SEEK_SET);  // rewind to start of file
-    fwrite(&metadata, sizeof(VideoMetadata), 1, outputFile);  // write header
+    update_metadata(outputFile, newFrameCount, height, width);
 
     for (int64_t frame = 0; frame < numFrames; frame++) {
         size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
         if (bytesRead != frameSize) {
             perror("Error reading frame data");
-            free(frameBuffer);
+            pool_release(frameBuffer);
             exit(1);
         }
 
@@ -48,13 +50,13 @@ void speed_up(FILE *inputFile, FILE *outputFile, int64_t numFrames,
             size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
             if (bytesWritten != frameSize) {
                 perror("Error writing frame data");
-                free(frameBuffer);
+                pool_release(frameBuffer);
                 exit(1);
             }
         }
     }
     // Free the frame buffer
-    free(frameBuffer);
+    pool_release(frameBuffer);
     printf("Fast forward operation completed successfully.\n");
 }
 
@@ -96,13 +98,13 @@ void crop_aspect_ratio(FILE *inputFile, FILE *outputFile, int64_t numFrames,
     // Allocate buffers for original and cropped frames
     size_t originalFrameSize = originalWidth * originalHeight * channels;
     size_t croppedFrameSize = targetWidth * targetHeight * channels;
-    unsigned char *originalFrame = malloc(originalFrameSize);
-    unsigned char *croppedFrame = malloc(croppedFrameSize);
+    unsigned char *originalFrame = pool_acquire(originalFrameSize);
+    unsigned char *croppedFrame = pool_acquire(croppedFrameSize);
 
     if (!originalFrame || !croppedFrame) {
         perror("Error allocating memory");
-        free(originalFrame);
-        free(croppedFrame);
+        pool_release(originalFrame);
+        pool_release(croppedFrame);
         exit(1);
     }
 
@@ -111,22 +113,7 @@ void crop_aspect_ratio(FILE *inputFile, FILE *outputFile, int64_t numFrames,
     int cropLeft = (originalWidth - targetWidth) / 2;
 
     // Write updated metadata
-    #pragma pack(1)
-    typedef struct {
-        int64_t numFrames;
-        unsigned char channels;
-        unsigned char height;
-        unsigned char width;
-    } VideoMetadata;
-    #pragma pack()
-    VideoMetadata metadata = {numFrames, channels, targetHeight, targetWidth};
-    fseek(outputFile, 0, SEEK_SET);
-    if (fwrite(&metadata, sizeof(VideoMetadata), 1, outputFile) != 1) {
-        perror("Error writing metadata");
-        free(originalFrame);
-        free(croppedFrame);
-        exit(1);
-    }
+    update_metadata(outputFile, numFrames, targetHeight, targetWidth);
 
     // Process frames
     for (int64_t frame = 0; frame < numFrames; frame++) {
@@ -135,8 +122,8 @@ void crop_aspect_ratio(FILE *inputFile, FILE *outputFile, int64_t numFrames,
                 1, originalFrameSize, inputFile);
         if (bytesRead != originalFrameSize) {
             perror("Error reading frame data");
-            free(originalFrame);
-            free(croppedFrame);
+            pool_release(originalFrame);
+            pool_release(croppedFrame);
             exit(1);
         }
 
@@ -147,13 +134,10 @@ void crop_aspect_ratio(FILE *inputFile, FILE *outputFile, int64_t numFrames,
             unsigned char *croppedChannelStart = croppedFrame +
                                 ch * targetWidth * targetHeight;
 
-            for (unsigned char row = 0; row < targetHeight; row++) {
-                for (unsigned char col = 0; col < targetWidth; col++) {
-                    croppedChannelStart[row * targetWidth + col] =
-                        originalChannelStart[(row + cropTop) * originalWidth
-                            + (col + cropLeft)];
-                }
-            }
+            // Whole rows of the crop window with vector copies
+            copy_rows(originalChannelStart + cropTop * originalWidth
+                + cropLeft, originalWidth, croppedChannelStart, targetWidth,
+                targetHeight, targetWidth);
         }
 
         // Write cropped frame
@@ -161,14 +145,358 @@ void crop_aspect_ratio(FILE *inputFile, FILE *outputFile, int64_t numFrames,
                             croppedFrameSize, outputFile);
         if (bytesWritten != croppedFrameSize) {
             perror("Error writing cropped frame data");
-            free(originalFrame);
-            free(croppedFrame);
+            pool_release(originalFrame);
+            pool_release(croppedFrame);
             exit(1);
         }
     }
     // Free memory
-    free(originalFrame);
-    free(croppedFrame);
+    pool_release(originalFrame);
+    pool_release(croppedFrame);
     printf("Aspect ratio adjustment completed successfully."
         "Target aspect ratio: %.2f\n", targetAspectRatio);
 }
+
+// Parse a resolution string such as "64x36" into width and height
+static void parse_resolution(const char *resolutionStr,
+        unsigned char *width, unsigned char *height) {
+    int w, h;
+    if (sscanf(resolutionStr, "%dx%d", &w, &h) != 2
+            || w <= 0 || h <= 0 || w > 255 || h > 255) {
+        fprintf(stderr, "Error: Invalid resolution format. "
+            "Use WIDTHxHEIGHT with each side in 1-255 (e.g., 64x36).\n");
+        exit(1);
+    }
+    *width = (unsigned char)w;
+    *height = (unsigned char)h;
+}
+
+// Source samples and weights for one output row or column.
+// Bilinear taps use i0/i1 with 7-bit weights w0 + w1 = 128,
+// box taps average every sample in [i0, i1).
+typedef struct {
+    int i0;
+    int i1;
+    int16_t w0;
+    int16_t w1;
+} ResizeTap;
+
+static void compute_bilinear_taps(ResizeTap *taps, int outSize, int inSize) {
+    float scale = (float)inSize / outSize;
+    for (int i = 0; i < outSize; i++) {
+        // Sample at pixel centres so edges line up on up and downscale
+        float src = (i + 0.5f) * scale - 0.5f;
+        if (src < 0) src = 0;
+        int index = (int)src;
+        if (index > inSize - 1) index = inSize - 1;
+        int weight = (int)((src - index) * 128 + 0.5f);
+        taps[i].i0 = index;
+        taps[i].i1 = index + 1 < inSize ? index + 1 : inSize - 1;
+        taps[i].w1 = (int16_t)weight;
+        taps[i].w0 = (int16_t)(128 - weight);
+    }
+}
+
+static void compute_box_taps(ResizeTap *taps, int outSize, int inSize) {
+    for (int i = 0; i < outSize; i++) {
+        int start = i * inSize / outSize;
+        int end = (i + 1) * inSize / outSize;
+        if (end <= start) end = start + 1;  // upscaling falls back to nearest
+        taps[i].i0 = start;
+        taps[i].i1 = end;
+        taps[i].w0 = (int16_t)(end - start);
+        taps[i].w1 = 0;
+    }
+}
+
+TARGET_AVX2
+static int lerp_rows_avx2(const unsigned char *r0, const unsigned char *r1,
+        int16_t w0, int16_t w1, uint16_t *rowOut, int n) {
+    int x = 0;
+    __m256i weight0 = _mm256_set1_epi16(w0);
+    __m256i weight1 = _mm256_set1_epi16(w1);
+    for (; x + 16 <= n; x += 16) {
+        __m256i a = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(r0 + x)));
+        __m256i b = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(r1 + x)));
+        __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(a, weight0),
+                                       _mm256_mullo_epi16(b, weight1));
+        _mm256_storeu_si256((__m256i *)(rowOut + x), sum);
+    }
+    return x;
+}
+
+// rowOut[x] = r0[x] * w0 + r1[x] * w1, at most 255 * 128 so fits 16 bits
+static void lerp_rows(const unsigned char *r0, const unsigned char *r1,
+        int16_t w0, int16_t w1, uint16_t *rowOut, int n) {
+    int x = 0;
+    if (simd_level() >= SIMD_AVX2) {
+        x = lerp_rows_avx2(r0, r1, w0, w1, rowOut, n);
+    }
+    for (; x < n; x++) {
+        rowOut[x] = (uint16_t)(r0[x] * w0 + r1[x] * w1);
+    }
+}
+
+TARGET_AVX2
+static int accumulate_row_avx2(const unsigned char *row, uint16_t *rowOut,
+        int n) {
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        __m256i a = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(row + x)));
+        __m256i acc = _mm256_loadu_si256((const __m256i *)(rowOut + x));
+        _mm256_storeu_si256((__m256i *)(rowOut + x),
+                            _mm256_add_epi16(acc, a));
+    }
+    return x;
+}
+
+// rowOut[x] += row[x], at most 255 rows of 255 so fits 16 bits
+static void accumulate_row(const unsigned char *row, uint16_t *rowOut, int n) {
+    int x = 0;
+    if (simd_level() >= SIMD_AVX2) x = accumulate_row_avx2(row, rowOut, n);
+    for (; x < n; x++) {
+        rowOut[x] = (uint16_t)(rowOut[x] + row[x]);
+    }
+}
+
+// Resize one channel plane: vertical pass into rowBuffer, then horizontal
+static void resize_plane(const unsigned char *src, unsigned char *dst,
+        int inWidth, int outWidth, int outHeight,
+        const ResizeTap *colTaps, const ResizeTap *rowTaps,
+        bool boxFilter, uint16_t *rowBuffer) {
+    for (int y = 0; y < outHeight; y++) {
+        const ResizeTap *rowTap = &rowTaps[y];
+        unsigned char *out = dst + y * outWidth;
+
+        if (!boxFilter) {
+            lerp_rows(src + rowTap->i0 * inWidth, src + rowTap->i1 * inWidth,
+                rowTap->w0, rowTap->w1, rowBuffer, inWidth);
+            for (int x = 0; x < outWidth; x++) {
+                const ResizeTap *colTap = &colTaps[x];
+                uint32_t value = rowBuffer[colTap->i0] * colTap->w0
+                               + rowBuffer[colTap->i1] * colTap->w1;
+                out[x] = (unsigned char)((value + (1 << 13)) >> 14);
+            }
+        } else {
+            memset(rowBuffer, 0, inWidth * sizeof(uint16_t));
+            for (int row = rowTap->i0; row < rowTap->i1; row++) {
+                accumulate_row(src + row * inWidth, rowBuffer, inWidth);
+            }
+            for (int x = 0; x < outWidth; x++) {
+                const ResizeTap *colTap = &colTaps[x];
+                uint32_t sum = 0;
+                for (int col = colTap->i0; col < colTap->i1; col++) {
+                    sum += rowBuffer[col];
+                }
+                uint32_t area = colTap->w0 * rowTap->w0;
+                out[x] = (unsigned char)((sum + area / 2) / area);
+            }
+        }
+    }
+}
+
+void resize(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        const char *resolutionStr, const char *filterStr) {
+    unsigned char targetWidth, targetHeight;
+    parse_resolution(resolutionStr, &targetWidth, &targetHeight);
+
+    bool boxFilter = false;
+    if (filterStr != NULL) {
+        if (strcmp(filterStr, "box") == 0) {
+            boxFilter = true;
+        } else if (strcmp(filterStr, "bilinear") != 0) {
+            fprintf(stderr, "Error: Unknown resize filter %s. "
+                "Use bilinear or box.\n", filterStr);
+            exit(1);
+        }
+    }
+
+    size_t inFrameSize = height * width * channels;
+    size_t outFrameSize = targetHeight * targetWidth * channels;
+    size_t batchSize = 256;  // Number of frames per batch
+    int numThreads = omp_get_max_threads();
+
+    // Weights depend only on the dimensions, so compute them once
+    ResizeTap *colTaps = malloc(targetWidth * sizeof(ResizeTap));
+    ResizeTap *rowTaps = malloc(targetHeight * sizeof(ResizeTap));
+    unsigned char *inBatch = pool_acquire(batchSize * inFrameSize);
+    unsigned char *outBatch = pool_acquire(batchSize * outFrameSize);
+    // One intermediate row per thread
+    uint16_t *rowBuffers = pool_acquire(numThreads * width * sizeof(uint16_t));
+
+    if (!colTaps || !rowTaps || !inBatch || !outBatch || !rowBuffers) {
+        perror("Error allocating memory");
+        free(colTaps);
+        free(rowTaps);
+        pool_release(inBatch);
+        pool_release(outBatch);
+        pool_release(rowBuffers);
+        exit(1);
+    }
+
+    if (boxFilter) {
+        compute_box_taps(colTaps, targetWidth, width);
+        compute_box_taps(rowTaps, targetHeight, height);
+    } else {
+        compute_bilinear_taps(colTaps, targetWidth, width);
+        compute_bilinear_taps(rowTaps, targetHeight, height);
+    }
+
+    // Write updated metadata
+    update_metadata(outputFile, numFrames, targetHeight, targetWidth);
+
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(inBatch, inFrameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            exit(1);
+        }
+
+        // Frames are independent, so split the batch across threads
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            uint16_t *rowBuffer = rowBuffers + omp_get_thread_num() * width;
+            for (unsigned char ch = 0; ch < channels; ch++) {
+                resize_plane(
+                    inBatch + frame * inFrameSize + ch * height * width,
+                    outBatch + frame * outFrameSize
+                        + ch * targetHeight * targetWidth,
+                    width, targetWidth, targetHeight,
+                    colTaps, rowTaps, boxFilter, rowBuffer);
+            }
+        }
+
+        if (fwrite(outBatch, outFrameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing resized frame data");
+            exit(1);
+        }
+    }
+
+    free(colTaps);
+    free(rowTaps);
+    pool_release(inBatch);
+    pool_release(outBatch);
+    pool_release(rowBuffers);
+    printf("Resize completed successfully. New resolution: %dx%d\n",
+        targetWidth, targetHeight);
+}
+
+// Name of the file for a proxy level, "out.bin" becomes "out_2.bin"
+static char *proxy_path(const char *outputPath, int level) {
+    size_t length = strlen(outputPath);
+    char *path = malloc(length + 16);
+    if (!path) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    const char *slash = strrchr(outputPath, '/');
+    const char *dot = strrchr(outputPath, '.');
+    if (!dot || (slash && dot < slash)) dot = outputPath + length;
+    snprintf(path, length + 16, "%.*s_%d%s", (int)(dot - outputPath),
+        outputPath, level, dot);
+    return path;
+}
+
+void proxies(FILE *inputFile, FILE *outputFile, const char *outputPath,
+        const VideoMetadata *metadata, int levels) {
+    if (levels < 1 || levels > MAX_PROXY_LEVELS) {
+        fprintf(stderr, "Error: Proxy levels must be between 1 and %d.\n",
+            MAX_PROXY_LEVELS);
+        exit(1);
+    }
+
+    int64_t numFrames = metadata->numFrames;
+    unsigned char channels = metadata->channels;
+    size_t batchSize = 256;  // Number of frames per batch
+
+    // Level 0 is the source, each level halves the one above rounding up
+    int heights[MAX_PROXY_LEVELS + 1], widths[MAX_PROXY_LEVELS + 1];
+    size_t frameSizes[MAX_PROXY_LEVELS + 1];
+    unsigned char *batches[MAX_PROXY_LEVELS + 1] = {0};
+    FILE *files[MAX_PROXY_LEVELS + 1] = {0};
+    heights[0] = metadata->height;
+    widths[0] = metadata->width;
+    for (int level = 0; level <= levels; level++) {
+        if (level > 0) {
+            heights[level] = (heights[level - 1] + 1) / 2;
+            widths[level] = (widths[level - 1] + 1) / 2;
+        }
+        frameSizes[level] = heights[level] * widths[level] * channels;
+        batches[level] = pool_acquire(batchSize * frameSizes[level]);
+        if (!batches[level]) {
+            perror("Error allocating memory");
+            exit(1);
+        }
+    }
+
+    // The first level goes to the output file, the rest to files named
+    // after it, each with its own header
+    files[1] = outputFile;
+    update_metadata(outputFile, numFrames, heights[1], widths[1]);
+    for (int level = 2; level <= levels; level++) {
+        char *path = proxy_path(outputPath, level);
+        VideoMetadata levelMetadata = *metadata;
+        levelMetadata.height = heights[level];
+        levelMetadata.width = widths[level];
+        files[level] = fopen(path, "wb");
+        if (!files[level] || fwrite(&levelMetadata, sizeof(VideoMetadata),
+                1, files[level]) != 1) {
+            perror("Error opening proxy file");
+            free(path);
+            exit(1);
+        }
+        free(path);
+    }
+
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(batches[0], frameSizes[0], framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            exit(1);
+        }
+
+        // Each level is filtered from the one above while it is still in
+        // cache, so the source is read once for every level
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            for (unsigned char ch = 0; ch < channels; ch++) {
+                for (int level = 1; level <= levels; level++) {
+                    downsample_2x2(batches[level - 1]
+                        + frame * frameSizes[level - 1]
+                        + ch * heights[level - 1] * widths[level - 1],
+                        batches[level] + frame * frameSizes[level]
+                        + ch * heights[level] * widths[level],
+                        heights[level - 1], widths[level - 1]);
+                }
+            }
+        }
+
+        for (int level = 1; level <= levels; level++) {
+            if (fwrite(batches[level], frameSizes[level], framesInBatch,
+                    files[level]) != (size_t)framesInBatch) {
+                perror("Error writing proxy frame data");
+                exit(1);
+            }
+        }
+    }
+
+    for (int level = 0; level <= levels; level++) {
+        pool_release(batches[level]);
+        if (level >= 2) fclose(files[level]);
+    }
+    printf("Proxies completed successfully. Smallest level: %dx%d\n",
+        widths[levels], heights[levels]);
+}
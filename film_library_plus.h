@@ -2,11 +2,25 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include "film_library.h"
 
+// A 255 pixel side reaches 1 pixel after 8 halvings
+#define MAX_PROXY_LEVELS 8
+
+// Frames 0, factor, 2 * factor... are kept, so the count rounds up
+int64_t speed_up_frames(int64_t numFrames, int speedFactor);
 void speed_up(FILE *inputFile, FILE *outputFile, int64_t numFrames,
         unsigned char height, unsigned char width,
         unsigned char channels, int speedFactor);
 
+float parse_aspect_ratio(const char *aspectRatioStr);
 void crop_aspect_ratio(FILE *inputFile, FILE *outputFile, int64_t numFrames,
         unsigned char originalWidth, unsigned char originalHeight,
         unsigned char channels, const char *aspectRatioStr);
+
+void resize(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        const char *resolutionStr, const char *filterStr);
+
+void proxies(FILE *inputFile, FILE *outputFile, const char *outputPath,
+        const VideoMetadata *metadata, int levels);
@@ -0,0 +1,123 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for posix_memalign, malloc, free
+#include <stdint.h>  // for SIZE_MAX
+#include <pthread.h>  // for the pool lock
+#include <sys/mman.h>  // for madvise
+#include "film_library_pool.h"
+
+#define POOL_ALIGNMENT 64
+#define POOL_MIN_SIZE 4096
+#define HUGE_PAGE_SIZE (2 << 20)
+#define POOL_CLASSES 15  // 4 KiB to 64 MiB
+
+// Sizes are rounded up to a power of two, so a buffer can be reused for
+// any request of the same class. Larger requests, such as whole-file
+// buffers, would waste up to half of a power of two, so they get exactly
+// their size in huge pages and are freed on release.
+typedef struct PoolBlock {
+    void *data;
+    int sizeClass;  // -1 for a block outside the classes
+    size_t size;
+    struct PoolBlock *next;
+} PoolBlock;
+
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static PoolBlock *freeBlocks[POOL_CLASSES];  // cached, per size class
+static PoolBlock *usedBlocks;  // acquired, searched on release
+static size_t heldBytes;
+static size_t highWater;
+
+// Smallest class holding size, -1 when it is larger than every class
+static int size_class(size_t size) {
+    for (int sizeClass = 0; sizeClass < POOL_CLASSES; sizeClass++) {
+        if (((size_t)POOL_MIN_SIZE << sizeClass) >= size) return sizeClass;
+    }
+    return -1;
+}
+
+void *pool_acquire(size_t size) {
+    int sizeClass = size_class(size);
+    size_t classSize;
+    if (sizeClass >= 0) {
+        classSize = (size_t)POOL_MIN_SIZE << sizeClass;
+    } else if (size <= SIZE_MAX - HUGE_PAGE_SIZE) {
+        classSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE
+                  * HUGE_PAGE_SIZE;
+    } else {
+        return NULL;  // cannot be rounded up, let alone allocated
+    }
+
+    pthread_mutex_lock(&poolLock);
+    PoolBlock *block = sizeClass >= 0 ? freeBlocks[sizeClass] : NULL;
+    if (block) {
+        freeBlocks[sizeClass] = block->next;
+    } else {
+        block = malloc(sizeof(PoolBlock));
+        size_t alignment = classSize >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE
+                                                       : POOL_ALIGNMENT;
+        if (!block || posix_memalign(&block->data, alignment, classSize)) {
+            pthread_mutex_unlock(&poolLock);
+            free(block);
+            return NULL;
+        }
+        if (classSize >= HUGE_PAGE_SIZE) {
+            // Fewer TLB misses on big batches, ignored if unsupported
+            madvise(block->data, classSize, MADV_HUGEPAGE);
+        }
+        block->sizeClass = sizeClass;
+        block->size = classSize;
+        heldBytes += classSize;
+        if (heldBytes > highWater) highWater = heldBytes;
+    }
+    block->next = usedBlocks;
+    usedBlocks = block;
+    pthread_mutex_unlock(&poolLock);
+    return block->data;
+}
+
+void pool_release(void *buffer) {
+    if (!buffer) return;
+    pthread_mutex_lock(&poolLock);
+    PoolBlock **link = &usedBlocks;
+    while (*link && (*link)->data != buffer) link = &(*link)->next;
+    PoolBlock *block = *link;
+    if (!block) {
+        pthread_mutex_unlock(&poolLock);
+        fprintf(stderr, "Error: Buffer was not acquired from the pool.\n");
+        abort();
+    }
+    *link = block->next;
+    if (block->sizeClass < 0) {
+        heldBytes -= block->size;
+        pthread_mutex_unlock(&poolLock);
+        free(block->data);
+        free(block);
+        return;
+    }
+    block->next = freeBlocks[block->sizeClass];
+    freeBlocks[block->sizeClass] = block;
+    pthread_mutex_unlock(&poolLock);
+}
+
+void pool_trim(void) {
+    pthread_mutex_lock(&poolLock);
+    for (int sizeClass = 0; sizeClass < POOL_CLASSES; sizeClass++) {
+        while (freeBlocks[sizeClass]) {
+            PoolBlock *block = freeBlocks[sizeClass];
+            freeBlocks[sizeClass] = block->next;
+            heldBytes -= block->size;
+            free(block->data);
+            free(block);
+        }
+    }
+    pthread_mutex_unlock(&poolLock);
+}
+
+size_t pool_high_water(void) {
+    pthread_mutex_lock(&poolLock);
+    size_t bytes = highWater;
+    pthread_mutex_unlock(&poolLock);
+    return bytes;
+}
@@ -0,0 +1,21 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_POOL_H
+#define LIB_FILMMASTER2000_POOL_H
+#include <stddef.h>
+
+// Library-wide pool of frame and batch buffers. Buffers are 64-byte
+// aligned, or 2 MiB aligned and backed by huge pages from 2 MiB up.
+// Released buffers up to 64 MiB are kept for the next acquire of a
+// similar size, so repeated operations stop allocating and faulting pages
+// in once warm. Larger buffers are allocated to size and freed on release.
+// All functions are thread safe.
+
+// Returns NULL when out of memory, like malloc
+void *pool_acquire(size_t size);
+// Returns a buffer to the pool, NULL is ignored
+void pool_release(void *buffer);
+// Frees every buffer not currently acquired
+void pool_trim(void);
+// Most bytes the pool has held at once, acquired or cached
+size_t pool_high_water(void);
+#endif
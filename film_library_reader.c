@@ -0,0 +1,394 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for malloc, calloc, free, strtoll, exit
+#include <string.h>  // for memcpy
+#include <stdbool.h>  // for boolean type
+#include <unistd.h>  // for sysconf
+#include <pthread.h>  // for the cache lock and prefetch thread
+#include <sys/mman.h>  // for mmap, madvise
+#include <sys/stat.h>  // for fstat
+#include "film_library.h"  // for VideoMetadata, frame_size, update_metadata
+#include "film_library_codec.h"  // for open_compressed_input
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_reader.h"
+
+#define DEFAULT_CACHE_FRAMES 64
+#define PREFETCH_DEPTH 8
+
+struct FilmReader {
+    VideoMetadata metadata;
+    size_t frameSize;
+    FILE *file;
+    unsigned char *mappedData;  // MAP_FAILED when reading through file
+    size_t mappedSize;
+    pthread_mutex_t fileLock;  // serialises reads through file
+    FrameTransform transform;
+    void *context;
+    int64_t lastFrame;  // last frame asked for, gives the direction
+
+    // Cache of transformed frames in least recently used order, NULL when
+    // frames come straight from the mapping
+    pthread_mutex_t lock;  // guards the cache and the prefetch request
+    unsigned char *cache;
+    size_t cacheFrames;
+    int64_t *slotFrame;  // frame held in each slot, -1 when empty
+    int *newer;  // list links between slots, -1 at either end
+    int *older;
+    int newest;
+    int oldest;
+    int *frameSlot;  // slot holding each frame, -1 when not cached
+
+    // Frames ahead of the last lookup are loaded by a background thread
+    pthread_t prefetcher;
+    bool prefetcherStarted;  // only a started thread can be joined
+    pthread_cond_t wake;
+    bool prefetchPending;
+    int64_t prefetchFrom;
+    int direction;
+    bool stopping;
+};
+
+// Read and transform one frame, safe to call without the cache lock.
+// Returns -1 when the frame cannot be read.
+static int load_frame(FilmReader *reader, int64_t frame,
+        unsigned char *buffer) {
+    if (reader->mappedData != MAP_FAILED) {
+        memcpy(buffer, reader->mappedData + sizeof(VideoMetadata)
+            + frame * reader->frameSize, reader->frameSize);
+    } else {
+        pthread_mutex_lock(&reader->fileLock);
+        bool failed = fseeko(reader->file, sizeof(VideoMetadata)
+                             + frame * reader->frameSize, SEEK_SET) != 0
+                   || fread(buffer, 1, reader->frameSize, reader->file)
+                      != reader->frameSize;
+        pthread_mutex_unlock(&reader->fileLock);
+        if (failed) {
+            perror("Error reading frame data");
+            return -1;
+        }
+    }
+    if (reader->transform) {
+        reader->transform(buffer, &reader->metadata, reader->context);
+    }
+    return 0;
+}
+
+// Move a slot to the newest end of the list, called with the lock held
+static void touch_slot(FilmReader *reader, int slot) {
+    if (reader->newest == slot) return;
+    // Unlink
+    if (reader->older[slot] != -1) {
+        reader->newer[reader->older[slot]] = reader->newer[slot];
+    } else {
+        reader->oldest = reader->newer[slot];
+    }
+    reader->older[reader->newer[slot]] = reader->older[slot];
+    // Relink as newest
+    reader->older[slot] = reader->newest;
+    reader->newer[slot] = -1;
+    reader->newer[reader->newest] = slot;
+    reader->newest = slot;
+}
+
+// Copy a cached frame out, called with the lock held
+static bool cache_lookup(FilmReader *reader, int64_t frame,
+        unsigned char *buffer) {
+    int slot = reader->frameSlot[frame];
+    if (slot == -1) return false;
+    touch_slot(reader, slot);
+    memcpy(buffer, reader->cache + slot * reader->frameSize,
+        reader->frameSize);
+    return true;
+}
+
+// Store a frame over the least recently used slot, called with the lock held
+static void cache_insert(FilmReader *reader, int64_t frame,
+        const unsigned char *data) {
+    int slot = reader->frameSlot[frame];
+    if (slot == -1) {
+        // Another thread may have loaded it meanwhile, otherwise evict
+        slot = reader->oldest;
+        if (reader->slotFrame[slot] != -1) {
+            reader->frameSlot[reader->slotFrame[slot]] = -1;
+        }
+        memcpy(reader->cache + slot * reader->frameSize, data,
+            reader->frameSize);
+        reader->slotFrame[slot] = frame;
+        reader->frameSlot[frame] = slot;
+    }
+    touch_slot(reader, slot);
+}
+
+static void *prefetch_frames(void *arg) {
+    FilmReader *reader = arg;
+    unsigned char *buffer = pool_acquire(reader->frameSize);
+    if (!buffer) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    // Never prefetch so far ahead that the frames being viewed get evicted
+    size_t depth = reader->cacheFrames / 2 < PREFETCH_DEPTH
+                 ? reader->cacheFrames / 2 : PREFETCH_DEPTH;
+
+    pthread_mutex_lock(&reader->lock);
+    while (!reader->stopping) {
+        if (!reader->prefetchPending) {
+            pthread_cond_wait(&reader->wake, &reader->lock);
+            continue;
+        }
+        int64_t from = reader->prefetchFrom;
+        int direction = reader->direction;
+        reader->prefetchPending = false;
+
+        for (size_t i = 0; i < depth; i++) {
+            int64_t frame = from + (int64_t)i * direction;
+            // Stop early when a newer lookup moves the playhead
+            if (frame < 0 || frame >= reader->metadata.numFrames
+                    || reader->prefetchPending || reader->stopping) {
+                break;
+            }
+            if (reader->frameSlot[frame] != -1) continue;
+            pthread_mutex_unlock(&reader->lock);
+            int status = load_frame(reader, frame, buffer);
+            pthread_mutex_lock(&reader->lock);
+            // A failed read is left for the lookup to report
+            if (status != 0) break;
+            cache_insert(reader, frame, buffer);
+        }
+    }
+    pthread_mutex_unlock(&reader->lock);
+    pool_release(buffer);
+    return NULL;
+}
+
+// Ask the kernel to page in the next frames along the playback direction
+static void advise_ahead(FilmReader *reader, int64_t frame, int direction) {
+    int64_t first = frame + direction;
+    int64_t last = frame + direction * PREFETCH_DEPTH;
+    if (first > last) {
+        int64_t swap = first;
+        first = last;
+        last = swap;
+    }
+    if (first < 0) first = 0;
+    if (last >= reader->metadata.numFrames) {
+        last = reader->metadata.numFrames - 1;
+    }
+    if (first > last) return;
+
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t start = sizeof(VideoMetadata) + first * reader->frameSize;
+    size_t end = sizeof(VideoMetadata) + (last + 1) * reader->frameSize;
+    start -= start % pageSize;
+    madvise(reader->mappedData + start, end - start, MADV_WILLNEED);
+}
+
+FilmReader *fm_open(const char *path, size_t cacheFrames,
+        FrameTransform transform, void *context) {
+    FilmReader *reader = calloc(1, sizeof(FilmReader));
+    if (!reader) {
+        perror("Error allocating memory");
+        return NULL;
+    }
+    reader->mappedData = MAP_FAILED;
+    reader->file = fopen(path, "rb");
+    if (!reader->file) {
+        perror("Error opening input file");
+        free(reader);
+        return NULL;
+    }
+    if (fread(&reader->metadata, sizeof(VideoMetadata), 1, reader->file)
+            != 1) {
+        perror("Error reading video metadata");
+        fclose(reader->file);
+        free(reader);
+        return NULL;
+    }
+    if (reader->metadata.format & FORMAT_COMPRESSED) {
+        reader->file = open_compressed_input(reader->file,
+            &reader->metadata);
+    }
+    reader->frameSize = frame_size(&reader->metadata);
+    reader->transform = transform;
+    reader->context = context;
+    reader->lastFrame = -1;
+    pthread_mutex_init(&reader->fileLock, NULL);
+    pthread_mutex_init(&reader->lock, NULL);
+    pthread_cond_init(&reader->wake, NULL);
+
+    // Map the whole file like reverse_fast, checking it is long enough
+    // first so a truncated file cannot fault on access
+    int fd = fileno(reader->file);
+    struct stat fileStat;
+    reader->mappedSize = sizeof(VideoMetadata)
+                       + reader->metadata.numFrames * reader->frameSize;
+    if (fd != -1 && fstat(fd, &fileStat) == 0
+            && (size_t)fileStat.st_size >= reader->mappedSize) {
+        reader->mappedData = mmap(NULL, reader->mappedSize, PROT_READ,
+            MAP_PRIVATE, fd, 0);
+    }
+
+    // Untransformed frames are served from the mapping, no cache needed
+    if (!transform && reader->mappedData != MAP_FAILED) {
+        return reader;
+    }
+
+    int64_t numFrames = reader->metadata.numFrames;
+    reader->cacheFrames = cacheFrames ? cacheFrames : DEFAULT_CACHE_FRAMES;
+    reader->cache = pool_acquire(reader->cacheFrames * reader->frameSize);
+    reader->slotFrame = malloc(reader->cacheFrames * sizeof(int64_t));
+    reader->newer = malloc(reader->cacheFrames * sizeof(int));
+    reader->older = malloc(reader->cacheFrames * sizeof(int));
+    reader->frameSlot = malloc((numFrames ? numFrames : 1) * sizeof(int));
+    if (!reader->cache || !reader->slotFrame || !reader->newer
+            || !reader->older || !reader->frameSlot) {
+        perror("Error allocating memory");
+        fm_close(reader);
+        return NULL;
+    }
+    for (size_t slot = 0; slot < reader->cacheFrames; slot++) {
+        reader->slotFrame[slot] = -1;
+        reader->older[slot] = (int)slot - 1;
+        reader->newer[slot] = slot + 1 < reader->cacheFrames ? (int)slot + 1
+                                                             : -1;
+    }
+    reader->oldest = 0;
+    reader->newest = reader->cacheFrames - 1;
+    for (int64_t frame = 0; frame < numFrames; frame++) {
+        reader->frameSlot[frame] = -1;
+    }
+    reader->direction = 1;
+
+    if (pthread_create(&reader->prefetcher, NULL, prefetch_frames,
+            reader) != 0) {
+        perror("Error starting prefetch thread");
+        fm_close(reader);
+        return NULL;
+    }
+    reader->prefetcherStarted = true;
+    return reader;
+}
+
+const VideoMetadata *fm_metadata(const FilmReader *reader) {
+    return &reader->metadata;
+}
+
+int fm_get_frame(FilmReader *reader, int64_t frame, unsigned char *buffer) {
+    if (frame < 0 || frame >= reader->metadata.numFrames) return -1;
+
+    if (!reader->cache) {
+        int64_t previous = __atomic_exchange_n(&reader->lastFrame, frame,
+            __ATOMIC_RELAXED);
+        memcpy(buffer, reader->mappedData + sizeof(VideoMetadata)
+            + frame * reader->frameSize, reader->frameSize);
+        advise_ahead(reader, frame, frame < previous ? -1 : 1);
+        return 0;
+    }
+
+    pthread_mutex_lock(&reader->lock);
+    if (frame != reader->lastFrame && reader->lastFrame != -1) {
+        reader->direction = frame > reader->lastFrame ? 1 : -1;
+    }
+    reader->lastFrame = frame;
+    bool cached = cache_lookup(reader, frame, buffer);
+    reader->prefetchFrom = frame + reader->direction;
+    reader->prefetchPending = true;
+    pthread_cond_signal(&reader->wake);
+    pthread_mutex_unlock(&reader->lock);
+
+    if (!cached) {
+        // Load outside the lock so other lookups are not held up
+        if (load_frame(reader, frame, buffer) != 0) return -1;
+        pthread_mutex_lock(&reader->lock);
+        cache_insert(reader, frame, buffer);
+        pthread_mutex_unlock(&reader->lock);
+    }
+    return 0;
+}
+
+void fm_close(FilmReader *reader) {
+    if (!reader) return;
+    if (reader->prefetcherStarted) {
+        pthread_mutex_lock(&reader->lock);
+        reader->stopping = true;
+        pthread_cond_signal(&reader->wake);
+        pthread_mutex_unlock(&reader->lock);
+        pthread_join(reader->prefetcher, NULL);
+    }
+    if (reader->mappedData != MAP_FAILED) {
+        munmap(reader->mappedData, reader->mappedSize);
+    }
+    fclose(reader->file);
+    pthread_mutex_destroy(&reader->fileLock);
+    pthread_mutex_destroy(&reader->lock);
+    pthread_cond_destroy(&reader->wake);
+    pool_release(reader->cache);
+    free(reader->slotFrame);
+    free(reader->newer);
+    free(reader->older);
+    free(reader->frameSlot);
+    free(reader);
+}
+
+void extract_frames(const char *inputPath, FILE *outputFile,
+        const char *frameList) {
+    FilmReader *reader = fm_open(inputPath, 0, NULL, NULL);
+    if (!reader) exit(1);
+    const VideoMetadata *metadata = fm_metadata(reader);
+
+    // Parse the comma separated frame numbers
+    int64_t numFrames = 1;
+    for (const char *c = frameList; *c; c++) {
+        if (*c == ',') numFrames++;
+    }
+    int64_t *frames = malloc(numFrames * sizeof(int64_t));
+    unsigned char *buffer = pool_acquire(reader->frameSize);
+    if (!frames || !buffer) {
+        perror("Error allocating memory");
+        free(frames);
+        pool_release(buffer);
+        fm_close(reader);
+        exit(1);
+    }
+    const char *c = frameList;
+    for (int64_t i = 0; i < numFrames; i++) {
+        char *end;
+        frames[i] = strtoll(c, &end, 10);
+        if (end == c || (*end != ',' && *end != '\0')
+                || frames[i] < 0 || frames[i] >= metadata->numFrames) {
+            fprintf(stderr, "Error: Frame list must be frame numbers "
+                "below %ld separated by commas.\n",
+                (int64_t)metadata->numFrames);
+            free(frames);
+            pool_release(buffer);
+            fm_close(reader);
+            exit(1);
+        }
+        c = end + 1;
+    }
+
+    update_metadata(outputFile, numFrames, metadata->height,
+        metadata->width);
+    for (int64_t i = 0; i < numFrames; i++) {
+        if (fm_get_frame(reader, frames[i], buffer) != 0) {
+            free(frames);
+            pool_release(buffer);
+            fm_close(reader);
+            exit(1);
+        }
+        if (fwrite(buffer, 1, reader->frameSize, outputFile)
+                != reader->frameSize) {
+            perror("Error writing frame data");
+            free(frames);
+            pool_release(buffer);
+            fm_close(reader);
+            exit(1);
+        }
+    }
+
+    free(frames);
+    pool_release(buffer);
+    fm_close(reader);
+    printf("Extracted %ld frames successfully.\n", numFrames);
+}
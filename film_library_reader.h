@@ -0,0 +1,28 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_READER_H
+#define LIB_FILMMASTER2000_READER_H
+#include <stdio.h>
+#include <stdint.h>
+#include "film_library.h"
+
+// Random access to the frames of a file. Lookups may be made from any
+// number of threads at once.
+typedef struct FilmReader FilmReader;
+
+// Applied in place to each frame before it is cached
+typedef void (*FrameTransform)(unsigned char *frame,
+    const VideoMetadata *metadata, void *context);
+
+// Frames are cached when there is a transform or the input is compressed,
+// cacheFrames of 0 picks a default. Returns NULL on error.
+FilmReader *fm_open(const char *path, size_t cacheFrames,
+    FrameTransform transform, void *context);
+const VideoMetadata *fm_metadata(const FilmReader *reader);
+// Copies frame into buffer, which holds frame_size bytes. Returns 0 on
+// success and -1 for a frame outside the file or a failed read.
+int fm_get_frame(FilmReader *reader, int64_t frame, unsigned char *buffer);
+void fm_close(FilmReader *reader);
+
+void extract_frames(const char *inputPath, FILE *outputFile,
+    const char *frameList);
+#endif
@@ -0,0 +1,162 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for exit
+#include <string.h>  // for memcpy, strcmp
+#include <omp.h>  // for OpenMP parallelization
+#include <stdint.h>  // for int64_t type
+#include <stdbool.h>  // for boolean type
+#include "film_library.h"  // for update_metadata
+#include "film_library_simd.h"  // for transpose_plane and reverse_bytes
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_rotate.h"
+
+typedef enum {
+    ROTATE_90,
+    ROTATE_180,
+    ROTATE_270,
+    FLIP_HORIZONTAL,
+    FLIP_VERTICAL,
+    TRANSPOSE
+} Orientation;
+
+// Writes one height x width plane in the new orientation
+static void orient_plane(const unsigned char *src, unsigned char *dst,
+        int height, int width, Orientation orientation) {
+    switch (orientation) {
+    case TRANSPOSE:
+        transpose_plane(src, width, dst, height, height, width);
+        break;
+    case ROTATE_90:
+        // Transposing the rows bottom up turns the image clockwise
+        transpose_plane(src + (height - 1) * width, -width, dst, height,
+                        height, width);
+        break;
+    case ROTATE_270:
+        // Writing the columns bottom up turns it anticlockwise
+        transpose_plane(src, width, dst + (width - 1) * height, -height,
+                        height, width);
+        break;
+    case ROTATE_180:
+        for (int row = 0; row < height; row++) {
+            reverse_bytes(src + row * width,
+                          dst + (height - 1 - row) * width, width);
+        }
+        break;
+    case FLIP_HORIZONTAL:
+        for (int row = 0; row < height; row++) {
+            reverse_bytes(src + row * width, dst + row * width, width);
+        }
+        break;
+    case FLIP_VERTICAL:
+        for (int row = 0; row < height; row++) {
+            memcpy(dst + (height - 1 - row) * width, src + row * width,
+                   width);
+        }
+        break;
+    }
+}
+
+static void orient_video(FILE *inputFile, FILE *outputFile,
+        int64_t numFrames, unsigned char height, unsigned char width,
+        unsigned char channels, Orientation orientation) {
+    // Quarter turns and transposes swap the dimensions
+    bool swapsAxes = orientation == ROTATE_90 || orientation == ROTATE_270
+                  || orientation == TRANSPOSE;
+    size_t planeSize = height * width;
+    size_t frameSize = planeSize * channels;
+    size_t batchSize = 256;  // Number of frames per batch
+    unsigned char *inBatch = pool_acquire(batchSize * frameSize);
+    unsigned char *outBatch = pool_acquire(batchSize * frameSize);
+    if (!inBatch || !outBatch) {
+        perror("Error allocating memory");
+        pool_release(inBatch);
+        pool_release(outBatch);
+        exit(1);
+    }
+
+    if (swapsAxes) {
+        update_metadata(outputFile, numFrames, width, height);
+    }
+
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(inBatch, frameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            exit(1);
+        }
+
+        // Frames are independent, so split the batch across threads
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            for (unsigned char ch = 0; ch < channels; ch++) {
+                size_t offset = frame * frameSize + ch * planeSize;
+                orient_plane(inBatch + offset, outBatch + offset, height,
+                             width, orientation);
+            }
+        }
+
+        if (fwrite(outBatch, frameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            pool_release(inBatch);
+            pool_release(outBatch);
+            exit(1);
+        }
+    }
+
+    pool_release(inBatch);
+    pool_release(outBatch);
+    if (swapsAxes) {
+        printf("Orientation changed successfully. New resolution: %dx%d\n",
+            height, width);
+    } else {
+        printf("Orientation changed successfully.\n");
+    }
+}
+
+void rotate(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        int degrees) {
+    Orientation orientation;
+    if (degrees == 90) {
+        orientation = ROTATE_90;
+    } else if (degrees == 180) {
+        orientation = ROTATE_180;
+    } else if (degrees == 270) {
+        orientation = ROTATE_270;
+    } else {
+        fprintf(stderr, "Error: Rotation must be 90, 180 or 270 degrees.\n");
+        exit(1);
+    }
+    orient_video(inputFile, outputFile, numFrames, height, width, channels,
+        orientation);
+}
+
+void flip(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        const char *direction) {
+    Orientation orientation;
+    if (strcmp(direction, "h") == 0) {
+        orientation = FLIP_HORIZONTAL;
+    } else if (strcmp(direction, "v") == 0) {
+        orientation = FLIP_VERTICAL;
+    } else {
+        fprintf(stderr, "Error: Flip direction must be h or v.\n");
+        exit(1);
+    }
+    orient_video(inputFile, outputFile, numFrames, height, width, channels,
+        orientation);
+}
+
+void transpose(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels) {
+    orient_video(inputFile, outputFile, numFrames, height, width, channels,
+        TRANSPOSE);
+}
@@ -0,0 +1,18 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_ROTATE_H
+#define LIB_FILMMASTER2000_ROTATE_H
+#include <stdio.h>
+#include <stdint.h>
+
+// Clockwise by 90, 180 or 270 degrees
+void rotate(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels,
+    int degrees);
+// "h" mirrors left to right, "v" top to bottom
+void flip(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels,
+    const char *direction);
+// Swaps rows and columns, mirroring about the main diagonal
+void transpose(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels);
+#endif
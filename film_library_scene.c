@@ -0,0 +1,190 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for malloc, free, exit
+#include <string.h>  // for memcpy
+#include <immintrin.h>  // for AVX2 intrinsics SIMD
+#include <stdint.h>  // for int64_t type
+#include "film_library.h"  // for update_metadata
+#include "film_library_simd.h"  // for simd_level
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_scene.h"
+
+// Sum over the whole 32-byte blocks, setting *done to the bytes covered
+TARGET_AVX2
+static uint64_t frame_sad_avx2(const unsigned char *a, const unsigned char *b,
+        size_t size, size_t *done) {
+    size_t i = 0;
+    // sad_epu8 leaves four 64-bit partial sums per 32 bytes
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 32 <= size; i += 32) {
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(
+            _mm256_loadu_si256((const __m256i *)(a + i)),
+            _mm256_loadu_si256((const __m256i *)(b + i))));
+    }
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc),
+                                _mm256_extracti128_si256(acc, 1));
+    *done = i;
+    return (uint64_t)_mm_cvtsi128_si64(sum)
+         + (uint64_t)_mm_extract_epi64(sum, 1);
+}
+
+uint64_t frame_sad(const unsigned char *a, const unsigned char *b,
+        size_t size) {
+    uint64_t sad = 0;
+    size_t i = 0;
+    if (simd_level() >= SIMD_AVX2) sad = frame_sad_avx2(a, b, size, &i);
+    for (; i < size; i++) {
+        sad += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    }
+    return sad;
+}
+
+void scene_index(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        float threshold) {
+    size_t channelSize = height * width;
+    size_t frameSize = channelSize * channels;
+    size_t batchSize = 256;  // Number of frames per batch
+
+    // Slot 0 holds the last frame of the previous batch
+    unsigned char *batch = pool_acquire((batchSize + 1) * frameSize);
+    double *differences = malloc(batchSize * sizeof(double));
+    int64_t *cuts = malloc(sizeof(int64_t));
+    int64_t numCuts = 0, cutCapacity = 1;
+    if (!batch || !differences || !cuts) {
+        perror("Error allocating memory");
+        pool_release(batch);
+        free(differences);
+        free(cuts);
+        exit(1);
+    }
+
+    fprintf(outputFile, "{\n  \"frames\": %ld,\n  \"threshold\": %.3f,\n"
+        "  \"difference\": [", numFrames, threshold);
+
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(batch + frameSize, frameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(batch);
+            free(differences);
+            free(cuts);
+            exit(1);
+        }
+
+        // Mean absolute difference per pixel against the previous frame,
+        // summed plane by plane
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            if (framesProcessed + frame == 0) {
+                differences[frame] = 0;
+                continue;
+            }
+            const unsigned char *current = batch + (frame + 1) * frameSize;
+            const unsigned char *previous = current - frameSize;
+            uint64_t sad = 0;
+            for (unsigned char ch = 0; ch < channels; ch++) {
+                sad += frame_sad(current + ch * channelSize,
+                                 previous + ch * channelSize, channelSize);
+            }
+            differences[frame] = (double)sad / frameSize;
+        }
+
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            int64_t index = framesProcessed + frame;
+            fprintf(outputFile, "%s%.3f", index ? ", " : "",
+                differences[frame]);
+            if (index == 0 || differences[frame] > threshold) {
+                if (numCuts == cutCapacity) {
+                    cutCapacity *= 2;
+                    int64_t *grown = realloc(cuts,
+                                             cutCapacity * sizeof(int64_t));
+                    if (!grown) {
+                        perror("Error allocating memory");
+                        pool_release(batch);
+                        free(differences);
+                        free(cuts);
+                        exit(1);
+                    }
+                    cuts = grown;
+                }
+                cuts[numCuts++] = index;
+            }
+        }
+        memcpy(batch, batch + framesInBatch * frameSize, frameSize);
+    }
+
+    // Each cut starts a new scene
+    fprintf(outputFile, "],\n  \"cuts\": [");
+    for (int64_t cut = 0; cut < numCuts; cut++) {
+        fprintf(outputFile, "%s%ld", cut ? ", " : "", cuts[cut]);
+    }
+    fprintf(outputFile, "]\n}\n");
+
+    pool_release(batch);
+    free(differences);
+    free(cuts);
+    printf("Scene index completed successfully. %ld scenes found.\n",
+        numCuts);
+}
+
+void dedupe(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        float threshold) {
+    if (threshold < 0) {
+        fprintf(stderr, "Error: Dedupe threshold must not be negative.\n");
+        exit(1);
+    }
+
+    size_t frameSize = height * width * channels;
+    unsigned char *frameBuffer = pool_acquire(frameSize);
+    unsigned char *keptFrame = pool_acquire(frameSize);
+    if (!frameBuffer || !keptFrame) {
+        perror("Error allocating memory");
+        pool_release(frameBuffer);
+        pool_release(keptFrame);
+        exit(1);
+    }
+
+    int64_t newFrameCount = 0;
+    for (int64_t frame = 0; frame < numFrames; frame++) {
+        size_t bytesRead = fread(frameBuffer, 1, frameSize, inputFile);
+        if (bytesRead != frameSize) {
+            perror("Error reading frame data");
+            pool_release(frameBuffer);
+            pool_release(keptFrame);
+            exit(1);
+        }
+
+        // Compare with the last kept frame so slow drift still gets through
+        if (frame > 0 && (double)frame_sad(frameBuffer, keptFrame, frameSize)
+                / frameSize <= threshold) {
+            continue;
+        }
+
+        size_t bytesWritten = fwrite(frameBuffer, 1, frameSize, outputFile);
+        if (bytesWritten != frameSize) {
+            perror("Error writing frame data");
+            pool_release(frameBuffer);
+            pool_release(keptFrame);
+            exit(1);
+        }
+        unsigned char *swap = keptFrame;
+        keptFrame = frameBuffer;
+        frameBuffer = swap;
+        newFrameCount++;
+    }
+
+    // The kept count is only known at the end
+    update_metadata(outputFile, newFrameCount, height, width);
+
+    pool_release(frameBuffer);
+    pool_release(keptFrame);
+    printf("Dedupe completed successfully. Kept %ld of %ld frames.\n",
+        newFrameCount, numFrames);
+}
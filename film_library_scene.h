@@ -0,0 +1,15 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_SCENE_H
+#define LIB_FILMMASTER2000_SCENE_H
+#include <stdio.h>
+#include <stdint.h>
+
+uint64_t frame_sad(const unsigned char *a, const unsigned char *b,
+    size_t size);
+void scene_index(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels,
+    float threshold);
+void dedupe(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels,
+    float threshold);
+#endif
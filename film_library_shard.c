@@ -0,0 +1,314 @@
+// Copyright 2025 Rose Laird
+
+#define _GNU_SOURCE  // for fopencookie
+
+#include <stdio.h>
+#include <stdlib.h>  // for calloc, free, exit, qsort
+#include <string.h>  // for memcpy, strlen
+#include <inttypes.h>  // for PRId64, SCNd64
+#include <stdbool.h>  // for boolean type
+#include <fcntl.h>  // for open, posix_fallocate
+#include <unistd.h>  // for pread, pwrite, ftruncate
+#include "film_library_shard.h"
+
+typedef struct {
+    FILE *file;
+    int fd;  // -1 for decoded input, which is read through file
+    VideoMetadata metadata;  // header of the slice
+    size_t frameSize;
+    int64_t dataStart;  // file offset of the first frame of the slice
+    int64_t position;  // read position in the slice stream
+} ShardInput;
+
+typedef struct {
+    int fd;
+    char *donePath;  // completion log, see record_shard
+    VideoMetadata *header;  // receives the header the operation writes
+    ShardPlan plan;
+    bool allocated;
+    int64_t position;  // write position in the operation's stream
+} ShardOutput;
+
+// Finished shards append "start frames total" lines to <output>.shards.
+// Every worker has allocated its range, so the file size says nothing
+// about which ranges were written, finalize checks this log instead.
+static char *done_path(const char *path) {
+    char *donePath = malloc(strlen(path) + sizeof(".shards"));
+    if (!donePath) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    strcpy(donePath, path);
+    strcat(donePath, ".shards");
+    return donePath;
+}
+
+static int record_shard(const char *donePath, const ShardPlan *plan) {
+    char line[96];
+    int length = snprintf(line, sizeof(line), "%" PRId64 " %" PRId64
+        " %" PRId64 "\n", plan->outputStart, plan->outputFrames,
+        plan->totalFrames);
+    // One short O_APPEND write, so concurrent workers do not interleave
+    int fd = open(donePath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return -1;
+    int status = write(fd, line, length) == length ? 0 : -1;
+    if (close(fd) != 0) status = -1;
+    return status;
+}
+
+static int shard_seek(int64_t *position, int64_t streamSize,
+        off64_t *offset, int whence) {
+    int64_t target = *offset;
+    if (whence == SEEK_CUR) target += *position;
+    if (whence == SEEK_END) target += streamSize;
+    if (target < 0) return -1;
+    *position = target;
+    *offset = target;
+    return 0;
+}
+
+static ssize_t shard_input_read(void *cookie, char *buf, size_t size) {
+    ShardInput *input = cookie;
+    int64_t streamSize = sizeof(VideoMetadata)
+                       + input->metadata.numFrames * input->frameSize;
+    size_t copied = 0;
+
+    if (input->position < (int64_t)sizeof(VideoMetadata)) {
+        // Header with the slice's frame count
+        copied = sizeof(VideoMetadata) - input->position;
+        if (copied > size) copied = size;
+        memcpy(buf, (const char *)&input->metadata + input->position, copied);
+        input->position += copied;
+    }
+    if (copied == size || input->position >= streamSize) return copied;
+
+    size_t length = size - copied;
+    if ((int64_t)length > streamSize - input->position) {
+        length = streamSize - input->position;
+    }
+    off_t offset = input->dataStart + input->position - sizeof(VideoMetadata);
+    ssize_t got;
+    if (input->fd >= 0) {
+        got = pread(input->fd, buf + copied, length, offset);
+    } else {
+        if (ftello(input->file) != offset
+                && fseeko(input->file, offset, SEEK_SET) != 0) {
+            return copied ? (ssize_t)copied : -1;
+        }
+        got = fread(buf + copied, 1, length, input->file);
+    }
+    if (got <= 0) return copied ? (ssize_t)copied : got;
+    input->position += got;
+    return copied + got;
+}
+
+static int shard_input_seek(void *cookie, off64_t *offset, int whence) {
+    ShardInput *input = cookie;
+    return shard_seek(&input->position, sizeof(VideoMetadata)
+                      + input->metadata.numFrames * input->frameSize,
+                      offset, whence);
+}
+
+static int shard_input_close(void *cookie) {
+    ShardInput *input = cookie;
+    int status = fclose(input->file);
+    free(input);
+    return status;
+}
+
+FILE *open_shard_input(FILE *inputFile, VideoMetadata *metadata,
+        int64_t start, int64_t end) {
+    ShardInput *input = calloc(1, sizeof(ShardInput));
+    if (!input) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    input->file = inputFile;
+    input->fd = fileno(inputFile);
+    input->frameSize = frame_size(metadata);
+    input->dataStart = sizeof(VideoMetadata) + start * input->frameSize;
+    metadata->numFrames = end - start;
+    input->metadata = *metadata;
+    input->position = sizeof(VideoMetadata);
+
+    cookie_io_functions_t functions = {
+        .read = shard_input_read,
+        .write = NULL,
+        .seek = shard_input_seek,
+        .close = shard_input_close,
+    };
+    FILE *slice = fopencookie(input, "rb", functions);
+    if (!slice) {
+        perror("Error opening input slice");
+        exit(1);
+    }
+    // Continue after the header, as for an unsliced file
+    fseeko(slice, sizeof(VideoMetadata), SEEK_SET);
+    return slice;
+}
+
+static ssize_t shard_output_write(void *cookie, const char *buf,
+        size_t size) {
+    ShardOutput *output = cookie;
+    size_t written = 0;
+
+    if (output->position < (int64_t)sizeof(VideoMetadata)) {
+        // The header is only written once every shard is done
+        written = sizeof(VideoMetadata) - output->position;
+        if (written > size) written = size;
+        memcpy((char *)output->header + output->position, buf, written);
+        output->position += written;
+    }
+    if (written == size) return written;
+
+    size_t frameSize = frame_size(output->header);
+    off_t dataStart = sizeof(VideoMetadata)
+                    + output->plan.outputStart * frameSize;
+    if (!output->allocated) {
+        // Reserve this shard's range up front, other workers fill the rest
+        if (output->plan.outputFrames > 0
+                && posix_fallocate(output->fd, dataStart,
+                                   output->plan.outputFrames * frameSize)
+                   != 0) {
+            return -1;
+        }
+        output->allocated = true;
+    }
+    while (written < size) {
+        ssize_t put = pwrite(output->fd, buf + written, size - written,
+            dataStart + output->position - sizeof(VideoMetadata));
+        if (put <= 0) return written ? (ssize_t)written : -1;
+        written += put;
+        output->position += put;
+    }
+    return written;
+}
+
+static int shard_output_seek(void *cookie, off64_t *offset, int whence) {
+    ShardOutput *output = cookie;
+    if (whence == SEEK_END) return -1;  // the shared file has no end yet
+    return shard_seek(&output->position, 0, offset, whence);
+}
+
+static int shard_output_close(void *cookie) {
+    ShardOutput *output = cookie;
+    int status = close(output->fd);
+    // Only a shard that wrote every one of its frames counts as done
+    int64_t expected = sizeof(VideoMetadata)
+                     + output->plan.outputFrames * frame_size(output->header);
+    if (status == 0 && output->position == expected
+            && record_shard(output->donePath, &output->plan) != 0) {
+        status = -1;
+    }
+    free(output->donePath);
+    free(output);
+    return status;
+}
+
+FILE *open_shard_output(const char *path, const ShardPlan *plan,
+        VideoMetadata *header) {
+    ShardOutput *output = calloc(1, sizeof(ShardOutput));
+    if (!output) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    // Other workers write to the same file, so it must not be truncated
+    output->fd = open(path, O_WRONLY | O_CREAT, 0644);
+    if (output->fd < 0) {
+        free(output);
+        return NULL;
+    }
+    output->donePath = done_path(path);
+    output->header = header;
+    output->plan = *plan;
+
+    cookie_io_functions_t functions = {
+        .read = NULL,
+        .write = shard_output_write,
+        .seek = shard_output_seek,
+        .close = shard_output_close,
+    };
+    FILE *file = fopencookie(output, "wb", functions);
+    if (!file) {
+        perror("Error opening output slice");
+        exit(1);
+    }
+    return file;
+}
+
+typedef struct {
+    int64_t start;
+    int64_t end;
+} FrameRange;
+
+static int compare_ranges(const void *a, const void *b) {
+    const FrameRange *first = a, *second = b;
+    return (first->start > second->start) - (first->start < second->start);
+}
+
+// True when the logged shards of this job cover frames [0, totalFrames)
+static bool shards_complete(const char *donePath, int64_t totalFrames) {
+    FILE *log = fopen(donePath, "r");
+    if (!log) return totalFrames == 0;
+    FrameRange *ranges = NULL;
+    size_t count = 0, capacity = 0;
+    int64_t start, frames, total;
+    while (fscanf(log, "%" SCNd64 " %" SCNd64 " %" SCNd64, &start, &frames,
+            &total) == 3) {
+        if (total != totalFrames) continue;  // from another job
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            FrameRange *grown = realloc(ranges, capacity * sizeof(FrameRange));
+            if (!grown) {
+                perror("Error allocating memory");
+                free(ranges);
+                fclose(log);
+                exit(1);
+            }
+            ranges = grown;
+        }
+        ranges[count++] = (FrameRange){start, start + frames};
+    }
+    fclose(log);
+
+    qsort(ranges, count, sizeof(FrameRange), compare_ranges);
+    int64_t covered = 0;
+    for (size_t i = 0; i < count && ranges[i].start <= covered; i++) {
+        if (ranges[i].end > covered) covered = ranges[i].end;
+    }
+    free(ranges);
+    return covered >= totalFrames;
+}
+
+int finalize_shard_output(const char *path, const ShardPlan *plan,
+        VideoMetadata *header) {
+    char *donePath = done_path(path);
+    if (!shards_complete(donePath, plan->totalFrames)) {
+        fprintf(stderr, "Error: Output is missing frames, "
+            "run every shard before finalizing.\n");
+        free(donePath);
+        return -1;
+    }
+    int fd = open(path, O_WRONLY);
+    if (fd < 0) {
+        perror("Error opening output file");
+        free(donePath);
+        return -1;
+    }
+    off_t size = sizeof(VideoMetadata)
+               + plan->totalFrames * frame_size(header);
+    // Drop anything past the last frame, e.g. from an earlier larger run
+    header->numFrames = plan->totalFrames;
+    if (ftruncate(fd, size) != 0
+            || pwrite(fd, header, sizeof(VideoMetadata), 0)
+               != sizeof(VideoMetadata)) {
+        perror("Error writing metadata");
+        close(fd);
+        free(donePath);
+        return -1;
+    }
+    // The job is done, a later one starts from an empty log
+    unlink(donePath);
+    free(donePath);
+    return close(fd);
+}
@@ -0,0 +1,31 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_SHARD_H
+#define LIB_FILMMASTER2000_SHARD_H
+#include <stdio.h>
+#include <stdint.h>
+#include "film_library.h"
+
+// Frames one worker reads and where its output lands in the shared file
+typedef struct {
+    int64_t inputStart;
+    int64_t inputEnd;
+    int64_t outputStart;
+    int64_t outputFrames;
+    int64_t totalFrames;  // frames in the finished output
+} ShardPlan;
+
+// Presents frames [start, end) of the input as a whole video, so any
+// operation can run on the slice unchanged. Takes ownership of inputFile.
+FILE *open_shard_input(FILE *inputFile, VideoMetadata *metadata,
+    int64_t start, int64_t end);
+// Writes the operation's frames into the shared output at plan->outputStart
+// with pwrite, without truncating it. The header goes to header instead.
+// Closing a shard that wrote all its frames logs it in <path>.shards.
+FILE *open_shard_output(const char *path, const ShardPlan *plan,
+    VideoMetadata *header);
+// Once the log shows every frame was written, cuts the output to
+// plan->totalFrames, writes header with that frame count and removes
+// the log
+int finalize_shard_output(const char *path, const ShardPlan *plan,
+    VideoMetadata *header);
+#endif
@@ -0,0 +1,1269 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>  // for fprintf
+#include <stdlib.h>  // for getenv
+#include <string.h>  // for memcpy, strcmp
+#include <stdbool.h>  // for boolean type
+#include <immintrin.h>  // for SSE2, AVX2 and AVX-512 intrinsics SIMD
+#include "film_library_simd.h"
+
+typedef struct {
+    void (*clip)(unsigned char *plane, size_t size, unsigned char min,
+        unsigned char max);
+    void (*scale)(unsigned char *plane, size_t size, float factor);
+    void (*swap)(unsigned char *a, unsigned char *b, size_t size);
+    void (*copy)(const unsigned char *src, unsigned char *dst, int width);
+    void (*lut)(const unsigned char *src, unsigned char *dst, size_t size,
+        const unsigned char lookupTable[256]);
+    void (*transpose)(const unsigned char *src, ptrdiff_t srcStride,
+        unsigned char *dst, ptrdiff_t dstStride, int rows, int cols);
+    void (*reverse)(const unsigned char *src, unsigned char *dst,
+        size_t size);
+    void (*blend)(const unsigned char *a, const unsigned char *b,
+        unsigned char *dst, size_t size, int weight);
+    void (*blendAlpha)(const unsigned char *a, const unsigned char *b,
+        const unsigned char *alpha, unsigned char *dst, size_t size);
+    void (*clipPacked)(unsigned char *pixels, size_t numPixels, int channels,
+        int channel, unsigned char min, unsigned char max);
+    void (*scalePacked)(unsigned char *pixels, size_t numPixels,
+        int channels, int channel, float factor);
+    void (*swapPacked)(unsigned char *pixels, size_t numPixels, int channels,
+        int channel1, int channel2);
+    void (*pack)(const unsigned char *planes, size_t planeStride,
+        int channels, unsigned char *pixels, size_t numPixels);
+    void (*unpack)(const unsigned char *pixels, int channels,
+        unsigned char *planes, size_t planeStride, size_t numPixels);
+} SimdKernels;
+
+static const char *levelNames[] = {"scalar", "sse2", "avx2", "avx512"};
+
+// Scalar kernels, also used for the tails of the vector ones
+
+static void clip_scalar(unsigned char *plane, size_t size,
+        unsigned char min, unsigned char max) {
+    for (size_t pixel = 0; pixel < size; pixel++) {
+        if (plane[pixel] > max) {
+            plane[pixel] = max;
+        } else if (plane[pixel] < min) {
+            plane[pixel] = min;
+        }
+    }
+}
+
+static void scale_scalar(unsigned char *plane, size_t size, float factor) {
+    for (size_t pixel = 0; pixel < size; pixel++) {
+        float scaledValue = plane[pixel] * factor;
+        if (scaledValue > 255) {
+            plane[pixel] = 255;
+        } else if (scaledValue < 0) {
+            plane[pixel] = 0;
+        } else {
+            plane[pixel] = (unsigned char)scaledValue;
+        }
+    }
+}
+
+static void swap_scalar(unsigned char *a, unsigned char *b, size_t size) {
+    for (size_t pixel = 0; pixel < size; pixel++) {
+        unsigned char temp = a[pixel];
+        a[pixel] = b[pixel];
+        b[pixel] = temp;
+    }
+}
+
+static void copy_scalar(const unsigned char *src, unsigned char *dst,
+        int width) {
+    memcpy(dst, src, width);
+}
+
+static void lut_scalar(const unsigned char *src, unsigned char *dst,
+        size_t size, const unsigned char lookupTable[256]) {
+    for (size_t pixel = 0; pixel < size; pixel++) {
+        dst[pixel] = lookupTable[src[pixel]];
+    }
+}
+
+static void transpose_scalar(const unsigned char *src, ptrdiff_t srcStride,
+        unsigned char *dst, ptrdiff_t dstStride, int rows, int cols) {
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            dst[col * dstStride + row] = src[row * srcStride + col];
+        }
+    }
+}
+
+static void reverse_scalar(const unsigned char *src, unsigned char *dst,
+        size_t size) {
+    for (size_t pixel = 0; pixel < size; pixel++) {
+        dst[pixel] = src[size - 1 - pixel];
+    }
+}
+
+// Blends are 8.8 fixed point so every product fits a 16-bit lane:
+// (a * (256 - w) + b * w + 128) >> 8 is at most 65408. Alpha 255 maps to
+// weight 256 so opaque pixels come out exactly b.
+
+static void blend_scalar(const unsigned char *a, const unsigned char *b,
+        unsigned char *dst, size_t size, int weight) {
+    for (size_t pixel = 0; pixel < size; pixel++) {
+        dst[pixel] = (a[pixel] * (256 - weight) + b[pixel] * weight + 128)
+                   >> 8;
+    }
+}
+
+static void blend_alpha_scalar(const unsigned char *a, const unsigned char *b,
+        const unsigned char *alpha, unsigned char *dst, size_t size) {
+    for (size_t pixel = 0; pixel < size; pixel++) {
+        int weight = alpha[pixel] + (alpha[pixel] >> 7);
+        dst[pixel] = (a[pixel] * (256 - weight) + b[pixel] * weight + 128)
+                   >> 8;
+    }
+}
+
+// Packed kernels take numPixels pixels of channels bytes each and change
+// only the selected byte of every pixel
+
+static void clip_packed_scalar(unsigned char *pixels, size_t numPixels,
+        int channels, int channel, unsigned char min, unsigned char max) {
+    for (size_t pixel = 0; pixel < numPixels; pixel++) {
+        clip_scalar(pixels + pixel * channels + channel, 1, min, max);
+    }
+}
+
+static void scale_packed_scalar(unsigned char *pixels, size_t numPixels,
+        int channels, int channel, float factor) {
+    for (size_t pixel = 0; pixel < numPixels; pixel++) {
+        scale_scalar(pixels + pixel * channels + channel, 1, factor);
+    }
+}
+
+static void swap_packed_scalar(unsigned char *pixels, size_t numPixels,
+        int channels, int channel1, int channel2) {
+    for (size_t pixel = 0; pixel < numPixels; pixel++) {
+        unsigned char *values = pixels + pixel * channels;
+        unsigned char temp = values[channel1];
+        values[channel1] = values[channel2];
+        values[channel2] = temp;
+    }
+}
+
+static void pack_scalar(const unsigned char *planes, size_t planeStride,
+        int channels, unsigned char *pixels, size_t numPixels) {
+    for (size_t pixel = 0; pixel < numPixels; pixel++) {
+        for (int ch = 0; ch < channels; ch++) {
+            pixels[pixel * channels + ch] = planes[ch * planeStride + pixel];
+        }
+    }
+}
+
+static void unpack_scalar(const unsigned char *pixels, int channels,
+        unsigned char *planes, size_t planeStride, size_t numPixels) {
+    for (size_t pixel = 0; pixel < numPixels; pixel++) {
+        for (int ch = 0; ch < channels; ch++) {
+            planes[ch * planeStride + pixel] = pixels[pixel * channels + ch];
+        }
+    }
+}
+
+// SSE2 kernels. There is no byte shuffle before SSSE3, so lookups stay
+// scalar at this level.
+
+static void clip_sse2(unsigned char *plane, size_t size, unsigned char min,
+        unsigned char max) {
+    __m128i vMin = _mm_set1_epi8((char)min);
+    __m128i vMax = _mm_set1_epi8((char)max);
+    size_t pixel = 0;
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m128i values = _mm_loadu_si128((const __m128i *)(plane + pixel));
+        values = _mm_max_epu8(_mm_min_epu8(values, vMax), vMin);
+        _mm_storeu_si128((__m128i *)(plane + pixel), values);
+    }
+    clip_scalar(plane + pixel, size - pixel, min, max);
+}
+
+static void scale_sse2(unsigned char *plane, size_t size, float factor) {
+    // Products are clamped as floats then truncated, as in scale_scalar
+    __m128 vFactor = _mm_set1_ps(factor);
+    __m128 vMax = _mm_set1_ps(255.0f);
+    __m128 vZero = _mm_setzero_ps();
+    __m128i zero = _mm_setzero_si128();
+    size_t pixel = 0;
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(plane + pixel));
+        __m128i words[2] = {_mm_unpacklo_epi8(bytes, zero),
+                            _mm_unpackhi_epi8(bytes, zero)};
+        __m128i dwords[4];
+        for (int i = 0; i < 4; i++) {
+            __m128i value = i & 1 ? _mm_unpackhi_epi16(words[i / 2], zero)
+                                  : _mm_unpacklo_epi16(words[i / 2], zero);
+            __m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(value), vFactor);
+            scaled = _mm_min_ps(_mm_max_ps(scaled, vZero), vMax);
+            dwords[i] = _mm_cvttps_epi32(scaled);
+        }
+        __m128i result = _mm_packus_epi16(
+            _mm_packs_epi32(dwords[0], dwords[1]),
+            _mm_packs_epi32(dwords[2], dwords[3]));
+        _mm_storeu_si128((__m128i *)(plane + pixel), result);
+    }
+    scale_scalar(plane + pixel, size - pixel, factor);
+}
+
+static void swap_sse2(unsigned char *a, unsigned char *b, size_t size) {
+    size_t pixel = 0;
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + pixel));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + pixel));
+        _mm_storeu_si128((__m128i *)(a + pixel), vb);
+        _mm_storeu_si128((__m128i *)(b + pixel), va);
+    }
+    swap_scalar(a + pixel, b + pixel, size - pixel);
+}
+
+static void copy_sse2(const unsigned char *src, unsigned char *dst,
+        int width) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        _mm_storeu_si128((__m128i *)(dst + x),
+                         _mm_loadu_si128((const __m128i *)(src + x)));
+    }
+    memcpy(dst + x, src + x, width - x);
+}
+
+// Byte transposes take 16 rows through four rounds of unpacks, pairing
+// rows 1, 2, 4 and then 8 apart, after which register c holds column c
+
+static void transpose_16x16_sse2(const unsigned char *src,
+        ptrdiff_t srcStride, unsigned char *dst, ptrdiff_t dstStride) {
+    __m128i a[16], b[16];
+    for (int i = 0; i < 16; i++) {
+        a[i] = _mm_loadu_si128((const __m128i *)(src + i * srcStride));
+    }
+    for (int i = 0; i < 8; i++) {
+        b[i] = _mm_unpacklo_epi8(a[2 * i], a[2 * i + 1]);
+        b[i + 8] = _mm_unpackhi_epi8(a[2 * i], a[2 * i + 1]);
+    }
+    for (int i = 0; i < 8; i++) {
+        int out = i / 4 * 8 + i % 4;
+        a[out] = _mm_unpacklo_epi16(b[2 * i], b[2 * i + 1]);
+        a[out + 4] = _mm_unpackhi_epi16(b[2 * i], b[2 * i + 1]);
+    }
+    for (int i = 0; i < 8; i++) {
+        int out = i / 2 * 4 + i % 2;
+        b[out] = _mm_unpacklo_epi32(a[2 * i], a[2 * i + 1]);
+        b[out + 2] = _mm_unpackhi_epi32(a[2 * i], a[2 * i + 1]);
+    }
+    for (int i = 0; i < 8; i++) {
+        a[2 * i] = _mm_unpacklo_epi64(b[2 * i], b[2 * i + 1]);
+        a[2 * i + 1] = _mm_unpackhi_epi64(b[2 * i], b[2 * i + 1]);
+    }
+    for (int i = 0; i < 16; i++) {
+        _mm_storeu_si128((__m128i *)(dst + i * dstStride), a[i]);
+    }
+}
+
+static void transpose_sse2(const unsigned char *src, ptrdiff_t srcStride,
+        unsigned char *dst, ptrdiff_t dstStride, int rows, int cols) {
+    int row = 0;
+    for (; row + 16 <= rows; row += 16) {
+        int col = 0;
+        for (; col + 16 <= cols; col += 16) {
+            transpose_16x16_sse2(src + row * srcStride + col, srcStride,
+                                 dst + col * dstStride + row, dstStride);
+        }
+        transpose_scalar(src + row * srcStride + col, srcStride,
+                         dst + col * dstStride + row, dstStride,
+                         16, cols - col);
+    }
+    transpose_scalar(src + row * srcStride, srcStride, dst + row, dstStride,
+                     rows - row, cols);
+}
+
+static void reverse_sse2(const unsigned char *src, unsigned char *dst,
+        size_t size) {
+    // Swap the bytes of each word, then reverse the words
+    size_t pixel = 0;
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m128i values = _mm_loadu_si128(
+            (const __m128i *)(src + size - 16 - pixel));
+        values = _mm_or_si128(_mm_slli_epi16(values, 8),
+                              _mm_srli_epi16(values, 8));
+        values = _mm_shufflelo_epi16(values, _MM_SHUFFLE(0, 1, 2, 3));
+        values = _mm_shufflehi_epi16(values, _MM_SHUFFLE(0, 1, 2, 3));
+        values = _mm_shuffle_epi32(values, _MM_SHUFFLE(1, 0, 3, 2));
+        _mm_storeu_si128((__m128i *)(dst + pixel), values);
+    }
+    reverse_scalar(src, dst + pixel, size - pixel);
+}
+
+// One lerp on 16-bit lanes holding bytes. Widening with unpack and
+// narrowing with packus both work per 64-bit half, so the bytes come back
+// out in their original order.
+static inline __m128i lerp_epi16_sse2(__m128i a, __m128i b, __m128i weight) {
+    __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(256), weight);
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, inverse),
+                                _mm_mullo_epi16(b, weight));
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+static void blend_sse2(const unsigned char *a, const unsigned char *b,
+        unsigned char *dst, size_t size, int weight) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i vWeight = _mm_set1_epi16((short)weight);
+    size_t pixel = 0;
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + pixel));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + pixel));
+        __m128i low = lerp_epi16_sse2(_mm_unpacklo_epi8(va, zero),
+                                      _mm_unpacklo_epi8(vb, zero), vWeight);
+        __m128i high = lerp_epi16_sse2(_mm_unpackhi_epi8(va, zero),
+                                       _mm_unpackhi_epi8(vb, zero), vWeight);
+        _mm_storeu_si128((__m128i *)(dst + pixel),
+                         _mm_packus_epi16(low, high));
+    }
+    blend_scalar(a + pixel, b + pixel, dst + pixel, size - pixel, weight);
+}
+
+static void blend_alpha_sse2(const unsigned char *a, const unsigned char *b,
+        const unsigned char *alpha, unsigned char *dst, size_t size) {
+    __m128i zero = _mm_setzero_si128();
+    size_t pixel = 0;
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + pixel));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + pixel));
+        __m128i vAlpha = _mm_loadu_si128((const __m128i *)(alpha + pixel));
+        __m128i lowAlpha = _mm_unpacklo_epi8(vAlpha, zero);
+        __m128i highAlpha = _mm_unpackhi_epi8(vAlpha, zero);
+        lowAlpha = _mm_add_epi16(lowAlpha, _mm_srli_epi16(lowAlpha, 7));
+        highAlpha = _mm_add_epi16(highAlpha, _mm_srli_epi16(highAlpha, 7));
+        __m128i low = lerp_epi16_sse2(_mm_unpacklo_epi8(va, zero),
+                                      _mm_unpacklo_epi8(vb, zero), lowAlpha);
+        __m128i high = lerp_epi16_sse2(_mm_unpackhi_epi8(va, zero),
+                                       _mm_unpackhi_epi8(vb, zero),
+                                       highAlpha);
+        _mm_storeu_si128((__m128i *)(dst + pixel),
+                         _mm_packus_epi16(low, high));
+    }
+    blend_alpha_scalar(a + pixel, b + pixel, alpha + pixel, dst + pixel,
+                       size - pixel);
+}
+// Strided kernels step over the whole pixels that fit one register, so the
+// selected channel sits at the same bytes on every step. The other bytes
+// get bounds of 0 and 255, or a factor of 1, and are stored back unchanged.
+static void clip_packed_sse2(unsigned char *pixels, size_t numPixels,
+        int channels, int channel, unsigned char min, unsigned char max) {
+    size_t size = numPixels * channels;
+    size_t byte = 0;
+    if (channels <= 16) {
+        size_t step = 16 / channels * channels;
+        unsigned char lows[16], highs[16];
+        for (size_t i = 0; i < 16; i++) {
+            bool selected = i < step && i % channels == (size_t)channel;
+            lows[i] = selected ? min : 0;
+            highs[i] = selected ? max : 255;
+        }
+        __m128i vMin = _mm_loadu_si128((const __m128i *)lows);
+        __m128i vMax = _mm_loadu_si128((const __m128i *)highs);
+        for (; byte + 16 <= size; byte += step) {
+            __m128i values = _mm_loadu_si128((const __m128i *)(pixels + byte));
+            values = _mm_max_epu8(_mm_min_epu8(values, vMax), vMin);
+            _mm_storeu_si128((__m128i *)(pixels + byte), values);
+        }
+    }
+    clip_packed_scalar(pixels + byte, (size - byte) / channels, channels,
+                       channel, min, max);
+}
+
+static void scale_packed_sse2(unsigned char *pixels, size_t numPixels,
+        int channels, int channel, float factor) {
+    size_t size = numPixels * channels;
+    size_t byte = 0;
+    if (channels <= 16) {
+        size_t step = 16 / channels * channels;
+        float factors[16];
+        for (size_t i = 0; i < 16; i++) {
+            factors[i] = i < step && i % channels == (size_t)channel ? factor
+                                                                      : 1.0f;
+        }
+        __m128 vFactors[4];
+        for (int i = 0; i < 4; i++) vFactors[i] = _mm_loadu_ps(factors + 4 * i);
+        __m128 vMax = _mm_set1_ps(255.0f);
+        __m128 vZero = _mm_setzero_ps();
+        __m128i zero = _mm_setzero_si128();
+        for (; byte + 16 <= size; byte += step) {
+            __m128i bytes = _mm_loadu_si128((const __m128i *)(pixels + byte));
+            __m128i words[2] = {_mm_unpacklo_epi8(bytes, zero),
+                                _mm_unpackhi_epi8(bytes, zero)};
+            __m128i dwords[4];
+            for (int i = 0; i < 4; i++) {
+                __m128i value = i & 1
+                    ? _mm_unpackhi_epi16(words[i / 2], zero)
+                    : _mm_unpacklo_epi16(words[i / 2], zero);
+                __m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(value),
+                                           vFactors[i]);
+                scaled = _mm_min_ps(_mm_max_ps(scaled, vZero), vMax);
+                dwords[i] = _mm_cvttps_epi32(scaled);
+            }
+            __m128i result = _mm_packus_epi16(
+                _mm_packs_epi32(dwords[0], dwords[1]),
+                _mm_packs_epi32(dwords[2], dwords[3]));
+            _mm_storeu_si128((__m128i *)(pixels + byte), result);
+        }
+    }
+    scale_packed_scalar(pixels + byte, (size - byte) / channels, channels,
+                        channel, factor);
+}
+
+// Four channels interleave with two rounds of unpacks and deinterleave
+// with shifts and packs, other counts need byte shuffles
+static void pack_sse2(const unsigned char *planes, size_t planeStride,
+        int channels, unsigned char *pixels, size_t numPixels) {
+    size_t pixel = 0;
+    if (channels == 4) {
+        for (; pixel + 16 <= numPixels; pixel += 16) {
+            __m128i v[4];
+            for (int ch = 0; ch < 4; ch++) {
+                v[ch] = _mm_loadu_si128(
+                    (const __m128i *)(planes + ch * planeStride + pixel));
+            }
+            __m128i low01 = _mm_unpacklo_epi8(v[0], v[1]);
+            __m128i high01 = _mm_unpackhi_epi8(v[0], v[1]);
+            __m128i low23 = _mm_unpacklo_epi8(v[2], v[3]);
+            __m128i high23 = _mm_unpackhi_epi8(v[2], v[3]);
+            __m128i *dst = (__m128i *)(pixels + pixel * 4);
+            _mm_storeu_si128(dst, _mm_unpacklo_epi16(low01, low23));
+            _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(low01, low23));
+            _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(high01, high23));
+            _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(high01, high23));
+        }
+    }
+    pack_scalar(planes + pixel, planeStride, channels,
+                pixels + pixel * channels, numPixels - pixel);
+}
+
+static void unpack_sse2(const unsigned char *pixels, int channels,
+        unsigned char *planes, size_t planeStride, size_t numPixels) {
+    size_t pixel = 0;
+    if (channels == 4) {
+        __m128i byteMask = _mm_set1_epi32(0xff);
+        for (; pixel + 16 <= numPixels; pixel += 16) {
+            const __m128i *src = (const __m128i *)(pixels + pixel * 4);
+            __m128i v[4];
+            for (int i = 0; i < 4; i++) v[i] = _mm_loadu_si128(src + i);
+            for (int ch = 0; ch < 4; ch++) {
+                __m128i d[4];
+                for (int i = 0; i < 4; i++) {
+                    d[i] = _mm_and_si128(_mm_srli_epi32(v[i], 8 * ch),
+                                         byteMask);
+                }
+                __m128i values = _mm_packus_epi16(_mm_packs_epi32(d[0], d[1]),
+                                                  _mm_packs_epi32(d[2], d[3]));
+                _mm_storeu_si128(
+                    (__m128i *)(planes + ch * planeStride + pixel), values);
+            }
+        }
+    }
+    unpack_scalar(pixels + pixel * channels, channels, planes + pixel,
+                  planeStride, numPixels - pixel);
+}
+
+// AVX2 kernels
+
+TARGET_AVX2
+static void clip_avx2(unsigned char *plane, size_t size, unsigned char min,
+        unsigned char max) {
+    __m256i vMin = _mm256_set1_epi8((char)min);
+    __m256i vMax = _mm256_set1_epi8((char)max);
+    size_t pixel = 0;
+    for (; pixel + 32 <= size; pixel += 32) {
+        __m256i values = _mm256_loadu_si256((const __m256i *)(plane + pixel));
+        values = _mm256_max_epu8(_mm256_min_epu8(values, vMax), vMin);
+        _mm256_storeu_si256((__m256i *)(plane + pixel), values);
+    }
+    clip_scalar(plane + pixel, size - pixel, min, max);
+}
+
+TARGET_AVX2
+static void scale_avx2(unsigned char *plane, size_t size, float factor) {
+    __m256 vFactor = _mm256_set1_ps(factor);
+    __m256 vMax = _mm256_set1_ps(255.0f);
+    __m256 vZero = _mm256_setzero_ps();
+    size_t pixel = 0;
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m256i dwords[2];
+        for (int i = 0; i < 2; i++) {
+            __m256i value = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i *)(plane + pixel + 8 * i)));
+            __m256 scaled = _mm256_mul_ps(_mm256_cvtepi32_ps(value), vFactor);
+            scaled = _mm256_min_ps(_mm256_max_ps(scaled, vZero), vMax);
+            dwords[i] = _mm256_cvttps_epi32(scaled);
+        }
+        // Both packs work per 128-bit lane, so restore the element order
+        __m256i words = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(dwords[0], dwords[1]), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i bytes = _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(words, words), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)(plane + pixel),
+                         _mm256_castsi256_si128(bytes));
+    }
+    scale_scalar(plane + pixel, size - pixel, factor);
+}
+
+TARGET_AVX2
+static void swap_avx2(unsigned char *a, unsigned char *b, size_t size) {
+    size_t pixel = 0;
+    for (; pixel + 32 <= size; pixel += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + pixel));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + pixel));
+        _mm256_storeu_si256((__m256i *)(a + pixel), vb);
+        _mm256_storeu_si256((__m256i *)(b + pixel), va);
+    }
+    swap_scalar(a + pixel, b + pixel, size - pixel);
+}
+
+TARGET_AVX2
+static void copy_avx2(const unsigned char *src, unsigned char *dst,
+        int width) {
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        _mm256_storeu_si256((__m256i *)(dst + x),
+                            _mm256_loadu_si256((const __m256i *)(src + x)));
+    }
+    memcpy(dst + x, src + x, width - x);
+}
+
+TARGET_AVX2
+static void lut_avx2(const unsigned char *src, unsigned char *dst,
+        size_t size, const unsigned char lookupTable[256]) {
+    // Split the table into 16 rows of 16 entries for byte shuffles, the
+    // high nibble selects the row and the low nibble the entry
+    __m256i rows[16];
+    for (int row = 0; row < 16; row++) {
+        rows[row] = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i *)(lookupTable + row * 16)));
+    }
+    __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+    size_t pixel = 0;
+    for (; pixel + 32 <= size; pixel += 32) {
+        __m256i values = _mm256_loadu_si256((const __m256i *)(src + pixel));
+        __m256i low = _mm256_and_si256(values, nibbleMask);
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(values, 4),
+                                        nibbleMask);
+        __m256i result = _mm256_setzero_si256();
+        for (int row = 0; row < 16; row++) {
+            __m256i match = _mm256_cmpeq_epi8(high, _mm256_set1_epi8(row));
+            result = _mm256_or_si256(result, _mm256_and_si256(match,
+                _mm256_shuffle_epi8(rows[row], low)));
+        }
+        _mm256_storeu_si256((__m256i *)(dst + pixel), result);
+    }
+    lut_scalar(src + pixel, dst + pixel, size - pixel, lookupTable);
+}
+
+// The same unpack rounds within each 128-bit lane transpose a 16 x 32
+// block as two 16 x 16 halves
+TARGET_AVX2
+static void transpose_16x32_avx2(const unsigned char *src,
+        ptrdiff_t srcStride, unsigned char *dst, ptrdiff_t dstStride) {
+    __m256i a[16], b[16];
+    for (int i = 0; i < 16; i++) {
+        a[i] = _mm256_loadu_si256((const __m256i *)(src + i * srcStride));
+    }
+    for (int i = 0; i < 8; i++) {
+        b[i] = _mm256_unpacklo_epi8(a[2 * i], a[2 * i + 1]);
+        b[i + 8] = _mm256_unpackhi_epi8(a[2 * i], a[2 * i + 1]);
+    }
+    for (int i = 0; i < 8; i++) {
+        int out = i / 4 * 8 + i % 4;
+        a[out] = _mm256_unpacklo_epi16(b[2 * i], b[2 * i + 1]);
+        a[out + 4] = _mm256_unpackhi_epi16(b[2 * i], b[2 * i + 1]);
+    }
+    for (int i = 0; i < 8; i++) {
+        int out = i / 2 * 4 + i % 2;
+        b[out] = _mm256_unpacklo_epi32(a[2 * i], a[2 * i + 1]);
+        b[out + 2] = _mm256_unpackhi_epi32(a[2 * i], a[2 * i + 1]);
+    }
+    for (int i = 0; i < 8; i++) {
+        a[2 * i] = _mm256_unpacklo_epi64(b[2 * i], b[2 * i + 1]);
+        a[2 * i + 1] = _mm256_unpackhi_epi64(b[2 * i], b[2 * i + 1]);
+    }
+    for (int i = 0; i < 16; i++) {
+        _mm_storeu_si128((__m128i *)(dst + i * dstStride),
+                         _mm256_castsi256_si128(a[i]));
+        _mm_storeu_si128((__m128i *)(dst + (i + 16) * dstStride),
+                         _mm256_extracti128_si256(a[i], 1));
+    }
+}
+
+TARGET_AVX2
+static void transpose_avx2(const unsigned char *src, ptrdiff_t srcStride,
+        unsigned char *dst, ptrdiff_t dstStride, int rows, int cols) {
+    int row = 0;
+    for (; row + 16 <= rows; row += 16) {
+        int col = 0;
+        for (; col + 32 <= cols; col += 32) {
+            transpose_16x32_avx2(src + row * srcStride + col, srcStride,
+                                 dst + col * dstStride + row, dstStride);
+        }
+        if (col + 16 <= cols) {
+            transpose_16x16_sse2(src + row * srcStride + col, srcStride,
+                                 dst + col * dstStride + row, dstStride);
+            col += 16;
+        }
+        transpose_scalar(src + row * srcStride + col, srcStride,
+                         dst + col * dstStride + row, dstStride,
+                         16, cols - col);
+    }
+    transpose_scalar(src + row * srcStride, srcStride, dst + row, dstStride,
+                     rows - row, cols);
+}
+
+TARGET_AVX2
+static void reverse_avx2(const unsigned char *src, unsigned char *dst,
+        size_t size) {
+    // Reverse within each lane, then swap the lanes
+    __m256i order = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5,
+        4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    size_t pixel = 0;
+    for (; pixel + 32 <= size; pixel += 32) {
+        __m256i values = _mm256_loadu_si256(
+            (const __m256i *)(src + size - 32 - pixel));
+        values = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(values, order),
+                                          _MM_SHUFFLE(1, 0, 3, 2));
+        _mm256_storeu_si256((__m256i *)(dst + pixel), values);
+    }
+    reverse_scalar(src, dst + pixel, size - pixel);
+}
+
+// The same lerp, 16 pixels per register half
+TARGET_AVX2
+static inline __m256i lerp_epi16_avx2(__m256i a, __m256i b, __m256i weight) {
+    __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(256), weight);
+    __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(a, inverse),
+                                   _mm256_mullo_epi16(b, weight));
+    return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(128)),
+                             8);
+}
+
+TARGET_AVX2
+static void blend_avx2(const unsigned char *a, const unsigned char *b,
+        unsigned char *dst, size_t size, int weight) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i vWeight = _mm256_set1_epi16((short)weight);
+    size_t pixel = 0;
+    for (; pixel + 32 <= size; pixel += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + pixel));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + pixel));
+        __m256i low = lerp_epi16_avx2(_mm256_unpacklo_epi8(va, zero),
+                                      _mm256_unpacklo_epi8(vb, zero),
+                                      vWeight);
+        __m256i high = lerp_epi16_avx2(_mm256_unpackhi_epi8(va, zero),
+                                       _mm256_unpackhi_epi8(vb, zero),
+                                       vWeight);
+        _mm256_storeu_si256((__m256i *)(dst + pixel),
+                            _mm256_packus_epi16(low, high));
+    }
+    blend_scalar(a + pixel, b + pixel, dst + pixel, size - pixel, weight);
+}
+
+TARGET_AVX2
+static void blend_alpha_avx2(const unsigned char *a, const unsigned char *b,
+        const unsigned char *alpha, unsigned char *dst, size_t size) {
+    __m256i zero = _mm256_setzero_si256();
+    size_t pixel = 0;
+    for (; pixel + 32 <= size; pixel += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + pixel));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + pixel));
+        __m256i vAlpha = _mm256_loadu_si256(
+            (const __m256i *)(alpha + pixel));
+        __m256i lowAlpha = _mm256_unpacklo_epi8(vAlpha, zero);
+        __m256i highAlpha = _mm256_unpackhi_epi8(vAlpha, zero);
+        lowAlpha = _mm256_add_epi16(lowAlpha,
+                                    _mm256_srli_epi16(lowAlpha, 7));
+        highAlpha = _mm256_add_epi16(highAlpha,
+                                     _mm256_srli_epi16(highAlpha, 7));
+        __m256i low = lerp_epi16_avx2(_mm256_unpacklo_epi8(va, zero),
+                                      _mm256_unpacklo_epi8(vb, zero),
+                                      lowAlpha);
+        __m256i high = lerp_epi16_avx2(_mm256_unpackhi_epi8(va, zero),
+                                       _mm256_unpackhi_epi8(vb, zero),
+                                       highAlpha);
+        _mm256_storeu_si256((__m256i *)(dst + pixel),
+                            _mm256_packus_epi16(low, high));
+    }
+    blend_alpha_scalar(a + pixel, b + pixel, alpha + pixel, dst + pixel,
+                       size - pixel);
+}
+
+TARGET_AVX2
+static void clip_packed_avx2(unsigned char *pixels, size_t numPixels,
+        int channels, int channel, unsigned char min, unsigned char max) {
+    size_t size = numPixels * channels;
+    size_t byte = 0;
+    if (channels <= 32) {
+        size_t step = 32 / channels * channels;
+        unsigned char lows[32], highs[32];
+        for (size_t i = 0; i < 32; i++) {
+            bool selected = i < step && i % channels == (size_t)channel;
+            lows[i] = selected ? min : 0;
+            highs[i] = selected ? max : 255;
+        }
+        __m256i vMin = _mm256_loadu_si256((const __m256i *)lows);
+        __m256i vMax = _mm256_loadu_si256((const __m256i *)highs);
+        for (; byte + 32 <= size; byte += step) {
+            __m256i values = _mm256_loadu_si256(
+                (const __m256i *)(pixels + byte));
+            values = _mm256_max_epu8(_mm256_min_epu8(values, vMax), vMin);
+            _mm256_storeu_si256((__m256i *)(pixels + byte), values);
+        }
+    }
+    clip_packed_scalar(pixels + byte, (size - byte) / channels, channels,
+                       channel, min, max);
+}
+
+TARGET_AVX2
+static void scale_packed_avx2(unsigned char *pixels, size_t numPixels,
+        int channels, int channel, float factor) {
+    size_t size = numPixels * channels;
+    size_t byte = 0;
+    if (channels <= 16) {
+        size_t step = 16 / channels * channels;
+        float factors[16];
+        for (size_t i = 0; i < 16; i++) {
+            factors[i] = i < step && i % channels == (size_t)channel ? factor
+                                                                      : 1.0f;
+        }
+        __m256 vFactors[2] = {_mm256_loadu_ps(factors),
+                              _mm256_loadu_ps(factors + 8)};
+        __m256 vMax = _mm256_set1_ps(255.0f);
+        __m256 vZero = _mm256_setzero_ps();
+        for (; byte + 16 <= size; byte += step) {
+            __m256i dwords[2];
+            for (int i = 0; i < 2; i++) {
+                __m256i value = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+                    (const __m128i *)(pixels + byte + 8 * i)));
+                __m256 scaled = _mm256_mul_ps(_mm256_cvtepi32_ps(value),
+                                              vFactors[i]);
+                scaled = _mm256_min_ps(_mm256_max_ps(scaled, vZero), vMax);
+                dwords[i] = _mm256_cvttps_epi32(scaled);
+            }
+            __m256i words = _mm256_permute4x64_epi64(
+                _mm256_packs_epi32(dwords[0], dwords[1]),
+                _MM_SHUFFLE(3, 1, 2, 0));
+            __m256i bytes = _mm256_permute4x64_epi64(
+                _mm256_packus_epi16(words, words), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i *)(pixels + byte),
+                             _mm256_castsi256_si128(bytes));
+        }
+    }
+    scale_packed_scalar(pixels + byte, (size - byte) / channels, channels,
+                        channel, factor);
+}
+
+TARGET_AVX2
+static void swap_packed_avx2(unsigned char *pixels, size_t numPixels,
+        int channels, int channel1, int channel2) {
+    // Byte shuffles stay within 128 bits, so step by the pixels in 16 bytes
+    size_t size = numPixels * channels;
+    size_t byte = 0;
+    if (channels <= 16) {
+        size_t step = 16 / channels * channels;
+        unsigned char order[16];
+        for (size_t i = 0; i < 16; i++) {
+            size_t ch = i % channels;
+            order[i] = i;
+            if (i < step && ch == (size_t)channel1) {
+                order[i] = i - channel1 + channel2;
+            } else if (i < step && ch == (size_t)channel2) {
+                order[i] = i - channel2 + channel1;
+            }
+        }
+        __m128i vOrder = _mm_loadu_si128((const __m128i *)order);
+        for (; byte + 16 <= size; byte += step) {
+            __m128i values = _mm_loadu_si128((const __m128i *)(pixels + byte));
+            _mm_storeu_si128((__m128i *)(pixels + byte),
+                             _mm_shuffle_epi8(values, vOrder));
+        }
+    }
+    swap_packed_scalar(pixels + byte, (size - byte) / channels, channels,
+                       channel1, channel2);
+}
+
+// Three channels: each 128-bit lane works on 16 pixels, 48 bytes in three
+// registers, and every output register ORs one shuffle of each input.
+// Lane 1 holds the next 16 pixels, so plane stores stay contiguous.
+TARGET_AVX2
+static size_t pack3_avx2(const unsigned char *planes, size_t planeStride,
+        unsigned char *pixels, size_t numPixels) {
+    // Byte j of packed block b comes from plane p's pixel, or nowhere (0x80)
+    unsigned char masks[3][3][16];
+    for (int p = 0; p < 3; p++) {
+        for (int b = 0; b < 3; b++) {
+            for (int j = 0; j < 16; j++) {
+                int position = 16 * b + j;
+                masks[p][b][j] = position % 3 == p ? position / 3 : 0x80;
+            }
+        }
+    }
+    __m256i vMasks[3][3];
+    for (int p = 0; p < 3; p++) {
+        for (int b = 0; b < 3; b++) {
+            vMasks[p][b] = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128((const __m128i *)masks[p][b]));
+        }
+    }
+    size_t pixel = 0;
+    for (; pixel + 32 <= numPixels; pixel += 32) {
+        __m256i v[3];
+        for (int p = 0; p < 3; p++) {
+            v[p] = _mm256_loadu_si256(
+                (const __m256i *)(planes + p * planeStride + pixel));
+        }
+        unsigned char *dst = pixels + pixel * 3;
+        for (int b = 0; b < 3; b++) {
+            __m256i block = _mm256_or_si256(
+                _mm256_or_si256(_mm256_shuffle_epi8(v[0], vMasks[0][b]),
+                                _mm256_shuffle_epi8(v[1], vMasks[1][b])),
+                _mm256_shuffle_epi8(v[2], vMasks[2][b]));
+            _mm_storeu_si128((__m128i *)(dst + 16 * b),
+                             _mm256_castsi256_si128(block));
+            _mm_storeu_si128((__m128i *)(dst + 48 + 16 * b),
+                             _mm256_extracti128_si256(block, 1));
+        }
+    }
+    return pixel;
+}
+
+TARGET_AVX2
+static size_t unpack3_avx2(const unsigned char *pixels, unsigned char *planes,
+        size_t planeStride, size_t numPixels) {
+    // Pixel i of plane p sits in block b at the given byte, or not (0x80)
+    unsigned char masks[3][3][16];
+    for (int p = 0; p < 3; p++) {
+        for (int b = 0; b < 3; b++) {
+            for (int i = 0; i < 16; i++) {
+                int position = 3 * i + p;
+                masks[p][b][i] = position / 16 == b ? position % 16 : 0x80;
+            }
+        }
+    }
+    __m256i vMasks[3][3];
+    for (int p = 0; p < 3; p++) {
+        for (int b = 0; b < 3; b++) {
+            vMasks[p][b] = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128((const __m128i *)masks[p][b]));
+        }
+    }
+    size_t pixel = 0;
+    for (; pixel + 32 <= numPixels; pixel += 32) {
+        const unsigned char *src = pixels + pixel * 3;
+        __m256i blocks[3];
+        for (int b = 0; b < 3; b++) {
+            blocks[b] = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *)(src + 16 * b))),
+                _mm_loadu_si128((const __m128i *)(src + 48 + 16 * b)), 1);
+        }
+        for (int p = 0; p < 3; p++) {
+            __m256i values = _mm256_or_si256(
+                _mm256_or_si256(_mm256_shuffle_epi8(blocks[0], vMasks[p][0]),
+                                _mm256_shuffle_epi8(blocks[1], vMasks[p][1])),
+                _mm256_shuffle_epi8(blocks[2], vMasks[p][2]));
+            _mm256_storeu_si256(
+                (__m256i *)(planes + p * planeStride + pixel), values);
+        }
+    }
+    return pixel;
+}
+
+// Four channels: unpacks interleave per lane, then whole lanes are moved
+// back into pixel order
+TARGET_AVX2
+static size_t pack4_avx2(const unsigned char *planes, size_t planeStride,
+        unsigned char *pixels, size_t numPixels) {
+    size_t pixel = 0;
+    for (; pixel + 32 <= numPixels; pixel += 32) {
+        __m256i v[4];
+        for (int ch = 0; ch < 4; ch++) {
+            v[ch] = _mm256_loadu_si256(
+                (const __m256i *)(planes + ch * planeStride + pixel));
+        }
+        __m256i low01 = _mm256_unpacklo_epi8(v[0], v[1]);
+        __m256i high01 = _mm256_unpackhi_epi8(v[0], v[1]);
+        __m256i low23 = _mm256_unpacklo_epi8(v[2], v[3]);
+        __m256i high23 = _mm256_unpackhi_epi8(v[2], v[3]);
+        // Pixels 0-3 | 16-19, 4-7 | 20-23, 8-11 | 24-27, 12-15 | 28-31
+        __m256i q0 = _mm256_unpacklo_epi16(low01, low23);
+        __m256i q1 = _mm256_unpackhi_epi16(low01, low23);
+        __m256i q2 = _mm256_unpacklo_epi16(high01, high23);
+        __m256i q3 = _mm256_unpackhi_epi16(high01, high23);
+        __m256i *dst = (__m256i *)(pixels + pixel * 4);
+        _mm256_storeu_si256(dst, _mm256_permute2x128_si256(q0, q1, 0x20));
+        _mm256_storeu_si256(dst + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+        _mm256_storeu_si256(dst + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+        _mm256_storeu_si256(dst + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+    }
+    return pixel;
+}
+
+TARGET_AVX2
+static size_t unpack4_avx2(const unsigned char *pixels, unsigned char *planes,
+        size_t planeStride, size_t numPixels) {
+    // Group each lane's 4 pixels by channel, then gather the 8 pixels of
+    // each channel into one 64-bit element, channels in order
+    __m256i group = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14,
+        3, 7, 11, 15, 0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t pixel = 0;
+    for (; pixel + 32 <= numPixels; pixel += 32) {
+        const __m256i *src = (const __m256i *)(pixels + pixel * 4);
+        __m256i v[4];
+        for (int i = 0; i < 4; i++) {
+            v[i] = _mm256_permutevar8x32_epi32(
+                _mm256_shuffle_epi8(_mm256_loadu_si256(src + i), group),
+                order);
+        }
+        // Channels 0 | 2 and 1 | 3 of pixels 0-15, then of 16-31
+        __m256i even01 = _mm256_unpacklo_epi64(v[0], v[1]);
+        __m256i odd01 = _mm256_unpackhi_epi64(v[0], v[1]);
+        __m256i even23 = _mm256_unpacklo_epi64(v[2], v[3]);
+        __m256i odd23 = _mm256_unpackhi_epi64(v[2], v[3]);
+        __m256i result[4] = {
+            _mm256_permute2x128_si256(even01, even23, 0x20),
+            _mm256_permute2x128_si256(odd01, odd23, 0x20),
+            _mm256_permute2x128_si256(even01, even23, 0x31),
+            _mm256_permute2x128_si256(odd01, odd23, 0x31)};
+        for (int ch = 0; ch < 4; ch++) {
+            _mm256_storeu_si256(
+                (__m256i *)(planes + ch * planeStride + pixel), result[ch]);
+        }
+    }
+    return pixel;
+}
+
+TARGET_AVX2
+static void pack_avx2(const unsigned char *planes, size_t planeStride,
+        int channels, unsigned char *pixels, size_t numPixels) {
+    size_t pixel = 0;
+    if (channels == 3) {
+        pixel = pack3_avx2(planes, planeStride, pixels, numPixels);
+    } else if (channels == 4) {
+        pixel = pack4_avx2(planes, planeStride, pixels, numPixels);
+    }
+    pack_scalar(planes + pixel, planeStride, channels,
+                pixels + pixel * channels, numPixels - pixel);
+}
+
+TARGET_AVX2
+static void unpack_avx2(const unsigned char *pixels, int channels,
+        unsigned char *planes, size_t planeStride, size_t numPixels) {
+    size_t pixel = 0;
+    if (channels == 3) {
+        pixel = unpack3_avx2(pixels, planes, planeStride, numPixels);
+    } else if (channels == 4) {
+        pixel = unpack4_avx2(pixels, planes, planeStride, numPixels);
+    }
+    unpack_scalar(pixels + pixel * channels, channels, planes + pixel,
+                  planeStride, numPixels - pixel);
+}
+
+// AVX-512BW kernels, byte masks cover the tails without a scalar loop
+
+TARGET_AVX512
+static __mmask64 tail_mask(size_t remaining) {
+    return remaining >= 64 ? ~(__mmask64)0
+                           : ((__mmask64)1 << remaining) - 1;
+}
+
+TARGET_AVX512
+static void clip_avx512(unsigned char *plane, size_t size, unsigned char min,
+        unsigned char max) {
+    __m512i vMin = _mm512_set1_epi8((char)min);
+    __m512i vMax = _mm512_set1_epi8((char)max);
+    for (size_t pixel = 0; pixel < size; pixel += 64) {
+        __mmask64 mask = tail_mask(size - pixel);
+        __m512i values = _mm512_maskz_loadu_epi8(mask, plane + pixel);
+        values = _mm512_max_epu8(_mm512_min_epu8(values, vMax), vMin);
+        _mm512_mask_storeu_epi8(plane + pixel, mask, values);
+    }
+}
+
+TARGET_AVX512
+static void scale_avx512(unsigned char *plane, size_t size, float factor) {
+    __m512 vFactor = _mm512_set1_ps(factor);
+    __m512 vMax = _mm512_set1_ps(255.0f);
+    __m512 vZero = _mm512_setzero_ps();
+    size_t pixel = 0;
+    for (; pixel + 16 <= size; pixel += 16) {
+        __m512i value = _mm512_cvtepu8_epi32(
+            _mm_loadu_si128((const __m128i *)(plane + pixel)));
+        __m512 scaled = _mm512_mul_ps(_mm512_cvtepi32_ps(value), vFactor);
+        scaled = _mm512_min_ps(_mm512_max_ps(scaled, vZero), vMax);
+        _mm_storeu_si128((__m128i *)(plane + pixel),
+                         _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(scaled)));
+    }
+    scale_scalar(plane + pixel, size - pixel, factor);
+}
+
+TARGET_AVX512
+static void swap_avx512(unsigned char *a, unsigned char *b, size_t size) {
+    for (size_t pixel = 0; pixel < size; pixel += 64) {
+        __mmask64 mask = tail_mask(size - pixel);
+        __m512i va = _mm512_maskz_loadu_epi8(mask, a + pixel);
+        __m512i vb = _mm512_maskz_loadu_epi8(mask, b + pixel);
+        _mm512_mask_storeu_epi8(a + pixel, mask, vb);
+        _mm512_mask_storeu_epi8(b + pixel, mask, va);
+    }
+}
+
+TARGET_AVX512
+static void copy_avx512(const unsigned char *src, unsigned char *dst,
+        int width) {
+    for (int x = 0; x < width; x += 64) {
+        __mmask64 mask = tail_mask(width - x);
+        _mm512_mask_storeu_epi8(dst + x, mask,
+                                _mm512_maskz_loadu_epi8(mask, src + x));
+    }
+}
+
+TARGET_AVX512
+static void lut_avx512(const unsigned char *src, unsigned char *dst,
+        size_t size, const unsigned char lookupTable[256]) {
+    // Same 16 row split as lut_avx2, with mask registers picking the row
+    __m512i rows[16];
+    for (int row = 0; row < 16; row++) {
+        rows[row] = _mm512_broadcast_i32x4(
+            _mm_loadu_si128((const __m128i *)(lookupTable + row * 16)));
+    }
+    __m512i nibbleMask = _mm512_set1_epi8(0x0f);
+    for (size_t pixel = 0; pixel < size; pixel += 64) {
+        __mmask64 mask = tail_mask(size - pixel);
+        __m512i values = _mm512_maskz_loadu_epi8(mask, src + pixel);
+        __m512i low = _mm512_and_si512(values, nibbleMask);
+        __m512i high = _mm512_and_si512(_mm512_srli_epi16(values, 4),
+                                        nibbleMask);
+        __m512i result = _mm512_setzero_si512();
+        for (int row = 0; row < 16; row++) {
+            __mmask64 match = _mm512_cmpeq_epi8_mask(high,
+                _mm512_set1_epi8(row));
+            result = _mm512_mask_shuffle_epi8(result, match, rows[row], low);
+        }
+        _mm512_mask_storeu_epi8(dst + pixel, mask, result);
+    }
+}
+
+TARGET_AVX512
+static inline __m512i lerp_epi16_avx512(__m512i a, __m512i b,
+        __m512i weight) {
+    __m512i inverse = _mm512_sub_epi16(_mm512_set1_epi16(256), weight);
+    __m512i sum = _mm512_add_epi16(_mm512_mullo_epi16(a, inverse),
+                                   _mm512_mullo_epi16(b, weight));
+    return _mm512_srli_epi16(_mm512_add_epi16(sum, _mm512_set1_epi16(128)),
+                             8);
+}
+
+TARGET_AVX512
+static void blend_avx512(const unsigned char *a, const unsigned char *b,
+        unsigned char *dst, size_t size, int weight) {
+    __m512i zero = _mm512_setzero_si512();
+    __m512i vWeight = _mm512_set1_epi16((short)weight);
+    for (size_t pixel = 0; pixel < size; pixel += 64) {
+        __mmask64 mask = tail_mask(size - pixel);
+        __m512i va = _mm512_maskz_loadu_epi8(mask, a + pixel);
+        __m512i vb = _mm512_maskz_loadu_epi8(mask, b + pixel);
+        __m512i low = lerp_epi16_avx512(_mm512_unpacklo_epi8(va, zero),
+                                        _mm512_unpacklo_epi8(vb, zero),
+                                        vWeight);
+        __m512i high = lerp_epi16_avx512(_mm512_unpackhi_epi8(va, zero),
+                                         _mm512_unpackhi_epi8(vb, zero),
+                                         vWeight);
+        _mm512_mask_storeu_epi8(dst + pixel, mask,
+                                _mm512_packus_epi16(low, high));
+    }
+}
+
+TARGET_AVX512
+static void blend_alpha_avx512(const unsigned char *a, const unsigned char *b,
+        const unsigned char *alpha, unsigned char *dst, size_t size) {
+    __m512i zero = _mm512_setzero_si512();
+    for (size_t pixel = 0; pixel < size; pixel += 64) {
+        __mmask64 mask = tail_mask(size - pixel);
+        __m512i va = _mm512_maskz_loadu_epi8(mask, a + pixel);
+        __m512i vb = _mm512_maskz_loadu_epi8(mask, b + pixel);
+        __m512i vAlpha = _mm512_maskz_loadu_epi8(mask, alpha + pixel);
+        __m512i lowAlpha = _mm512_unpacklo_epi8(vAlpha, zero);
+        __m512i highAlpha = _mm512_unpackhi_epi8(vAlpha, zero);
+        lowAlpha = _mm512_add_epi16(lowAlpha,
+                                    _mm512_srli_epi16(lowAlpha, 7));
+        highAlpha = _mm512_add_epi16(highAlpha,
+                                     _mm512_srli_epi16(highAlpha, 7));
+        __m512i low = lerp_epi16_avx512(_mm512_unpacklo_epi8(va, zero),
+                                        _mm512_unpacklo_epi8(vb, zero),
+                                        lowAlpha);
+        __m512i high = lerp_epi16_avx512(_mm512_unpackhi_epi8(va, zero),
+                                         _mm512_unpackhi_epi8(vb, zero),
+                                         highAlpha);
+        _mm512_mask_storeu_epi8(dst + pixel, mask,
+                                _mm512_packus_epi16(low, high));
+    }
+}
+
+// Byte transposes, reversals and packed layout shuffles gain nothing from
+// 512-bit registers without VBMI, so that level keeps the AVX2 versions.
+// Packed swaps and conversions need SSSE3 shuffles, and stay scalar at
+// the SSE2 level apart from four channel conversions.
+static const SimdKernels kernelTable[] = {
+    {clip_scalar, scale_scalar, swap_scalar, copy_scalar, lut_scalar,
+     transpose_scalar, reverse_scalar, blend_scalar, blend_alpha_scalar,
+     clip_packed_scalar, scale_packed_scalar, swap_packed_scalar,
+     pack_scalar, unpack_scalar},
+    {clip_sse2, scale_sse2, swap_sse2, copy_sse2, lut_scalar,
+     transpose_sse2, reverse_sse2, blend_sse2, blend_alpha_sse2,
+     clip_packed_sse2, scale_packed_sse2, swap_packed_scalar,
+     pack_sse2, unpack_sse2},
+    {clip_avx2, scale_avx2, swap_avx2, copy_avx2, lut_avx2,
+     transpose_avx2, reverse_avx2, blend_avx2, blend_alpha_avx2,
+     clip_packed_avx2, scale_packed_avx2, swap_packed_avx2,
+     pack_avx2, unpack_avx2},
+    {clip_avx512, scale_avx512, swap_avx512, copy_avx512, lut_avx512,
+     transpose_avx2, reverse_avx2, blend_avx512, blend_alpha_avx512,
+     clip_packed_avx2, scale_packed_avx2, swap_packed_avx2,
+     pack_avx2, unpack_avx2},
+};
+
+static SimdLevel currentLevel = SIMD_SCALAR;
+static const SimdKernels *kernels = &kernelTable[SIMD_SCALAR];
+
+// Runs before main so every caller sees the same level
+__attribute__((constructor))
+static void simd_init(void) {
+    __builtin_cpu_init();
+    SimdLevel supported = SIMD_SCALAR;
+    if (__builtin_cpu_supports("sse2")) supported = SIMD_SSE2;
+    if (__builtin_cpu_supports("avx2")) supported = SIMD_AVX2;
+    if (__builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512bw")) {
+        supported = SIMD_AVX512;
+    }
+
+    SimdLevel level = supported;
+    const char *override = getenv("FM_SIMD");
+    if (override) {
+        int requested = -1;
+        for (int i = SIMD_SCALAR; i <= SIMD_AVX512; i++) {
+            if (strcmp(override, levelNames[i]) == 0) requested = i;
+        }
+        if (requested == -1) {
+            fprintf(stderr, "Warning: Unknown FM_SIMD level %s, "
+                "using %s.\n", override, levelNames[supported]);
+        } else if (requested > (int)supported) {
+            fprintf(stderr, "Warning: This CPU does not support %s, "
+                "using %s.\n", override, levelNames[supported]);
+        } else {
+            level = requested;
+        }
+    }
+
+    currentLevel = level;
+    kernels = &kernelTable[level];
+}
+
+SimdLevel simd_level(void) {
+    return currentLevel;
+}
+
+const char *simd_level_name(SimdLevel level) {
+    return levelNames[level];
+}
+
+void clip_plane(unsigned char *plane, size_t size, unsigned char min,
+        unsigned char max) {
+    kernels->clip(plane, size, min, max);
+}
+
+void scale_plane(unsigned char *plane, size_t size, float factor) {
+    kernels->scale(plane, size, factor);
+}
+
+void swap_planes(unsigned char *a, unsigned char *b, size_t size) {
+    kernels->swap(a, b, size);
+}
+
+void copy_rows(const unsigned char *src, size_t srcStride, unsigned char *dst,
+        size_t dstStride, int rows, int width) {
+    for (int row = 0; row < rows; row++) {
+        kernels->copy(src + row * srcStride, dst + row * dstStride, width);
+    }
+}
+
+void apply_lut(const unsigned char *src, unsigned char *dst, size_t size,
+        const unsigned char lookupTable[256]) {
+    kernels->lut(src, dst, size, lookupTable);
+}
+
+// Tiles this size keep the rows being read and the columns being written
+// in L1 together
+#define TRANSPOSE_TILE 64
+
+void transpose_plane(const unsigned char *src, ptrdiff_t srcStride,
+        unsigned char *dst, ptrdiff_t dstStride, int rows, int cols) {
+    for (int row = 0; row < rows; row += TRANSPOSE_TILE) {
+        int tileRows = rows - row < TRANSPOSE_TILE ? rows - row
+                                                   : TRANSPOSE_TILE;
+        for (int col = 0; col < cols; col += TRANSPOSE_TILE) {
+            int tileCols = cols - col < TRANSPOSE_TILE ? cols - col
+                                                       : TRANSPOSE_TILE;
+            kernels->transpose(src + row * srcStride + col, srcStride,
+                               dst + col * dstStride + row, dstStride,
+                               tileRows, tileCols);
+        }
+    }
+}
+
+void reverse_bytes(const unsigned char *src, unsigned char *dst,
+        size_t size) {
+    kernels->reverse(src, dst, size);
+}
+
+void blend_planes(const unsigned char *a, const unsigned char *b,
+        unsigned char *dst, size_t size, int weight) {
+    kernels->blend(a, b, dst, size, weight);
+}
+
+void blend_planes_alpha(const unsigned char *a, const unsigned char *b,
+        const unsigned char *alpha, unsigned char *dst, size_t size) {
+    kernels->blendAlpha(a, b, alpha, dst, size);
+}
+
+void clip_packed(unsigned char *pixels, size_t numPixels, int channels,
+        int channel, unsigned char min, unsigned char max) {
+    kernels->clipPacked(pixels, numPixels, channels, channel, min, max);
+}
+
+void scale_packed(unsigned char *pixels, size_t numPixels, int channels,
+        int channel, float factor) {
+    kernels->scalePacked(pixels, numPixels, channels, channel, factor);
+}
+
+void swap_packed(unsigned char *pixels, size_t numPixels, int channels,
+        int channel1, int channel2) {
+    if (channel1 == channel2) return;
+    kernels->swapPacked(pixels, numPixels, channels, channel1, channel2);
+}
+
+void pack_planes(const unsigned char *planes, size_t planeSize,
+        int channels, unsigned char *pixels) {
+    if (channels == 1) {
+        memcpy(pixels, planes, planeSize);
+        return;
+    }
+    kernels->pack(planes, planeSize, channels, pixels, planeSize);
+}
+
+void unpack_pixels(const unsigned char *pixels, size_t planeSize,
+        int channels, unsigned char *planes) {
+    if (channels == 1) {
+        memcpy(planes, pixels, planeSize);
+        return;
+    }
+    kernels->unpack(pixels, channels, planes, planeSize, planeSize);
+}
@@ -0,0 +1,58 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_SIMD_H
+#define LIB_FILMMASTER2000_SIMD_H
+#include <stddef.h>
+
+// Instruction set levels, in increasing order. The level is picked once at
+// startup from cpuid, and can be lowered for testing by setting FM_SIMD to
+// scalar, sse2, avx2 or avx512.
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2,
+    SIMD_AVX512
+} SimdLevel;
+
+// Vector code is compiled per function, so the rest of the library only
+// assumes the baseline instruction set
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+SimdLevel simd_level(void);
+const char *simd_level_name(SimdLevel level);
+
+// Kernels dispatched to the best variant for the level
+void clip_plane(unsigned char *plane, size_t size, unsigned char min,
+    unsigned char max);
+void scale_plane(unsigned char *plane, size_t size, float factor);
+void swap_planes(unsigned char *a, unsigned char *b, size_t size);
+void copy_rows(const unsigned char *src, size_t srcStride, unsigned char *dst,
+    size_t dstStride, int rows, int width);
+void apply_lut(const unsigned char *src, unsigned char *dst, size_t size,
+    const unsigned char lookupTable[256]);
+// dst[col * dstStride + row] = src[row * srcStride + col], strides may be
+// negative to walk rows bottom up
+void transpose_plane(const unsigned char *src, ptrdiff_t srcStride,
+    unsigned char *dst, ptrdiff_t dstStride, int rows, int cols);
+// dst[i] = src[size - 1 - i], the buffers must not overlap
+void reverse_bytes(const unsigned char *src, unsigned char *dst,
+    size_t size);
+// dst = a + (b - a) * weight / 256 in 8.8 fixed point, weight 0 to 256
+void blend_planes(const unsigned char *a, const unsigned char *b,
+    unsigned char *dst, size_t size, int weight);
+// The same with a weight per pixel: alpha 0 keeps a, 255 gives b
+void blend_planes_alpha(const unsigned char *a, const unsigned char *b,
+    const unsigned char *alpha, unsigned char *dst, size_t size);
+// Packed pixels of channels bytes each, only byte channel of each changes
+void clip_packed(unsigned char *pixels, size_t numPixels, int channels,
+    int channel, unsigned char min, unsigned char max);
+void scale_packed(unsigned char *pixels, size_t numPixels, int channels,
+    int channel, float factor);
+void swap_packed(unsigned char *pixels, size_t numPixels, int channels,
+    int channel1, int channel2);
+// Between channels planes of planeSize bytes and planeSize packed pixels
+void pack_planes(const unsigned char *planes, size_t planeSize,
+    int channels, unsigned char *pixels);
+void unpack_pixels(const unsigned char *pixels, size_t planeSize,
+    int channels, unsigned char *planes);
+#endif
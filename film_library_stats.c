@@ -0,0 +1,410 @@
+// Copyright 2025 Rose Laird
+
+#include <stdio.h>
+#include <stdlib.h>  // for malloc, calloc, free
+#include <string.h>  // for memset
+#include <math.h>  // for sqrt
+#include <omp.h>  // for OpenMP parallelization
+#include <sys/mman.h>  // for memory mapping
+#include <stdint.h>  // for int64_t type
+#include <stdbool.h>  // for boolean type
+#include "film_library_simd.h"  // for apply_lut
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_stats.h"
+
+// Independent sub-histograms per plane so consecutive equal pixels do not
+// serialise on the same counter through store forwarding
+#define SUB_HISTOGRAMS 4
+
+void channel_histogram(const unsigned char *plane, size_t size,
+        uint32_t histogram[256]) {
+    uint32_t sub[SUB_HISTOGRAMS][256];
+    memset(sub, 0, sizeof(sub));
+
+    size_t pixel = 0;
+    for (; pixel + SUB_HISTOGRAMS <= size; pixel += SUB_HISTOGRAMS) {
+        // Constant trip count, unrolled by the compiler
+        for (int k = 0; k < SUB_HISTOGRAMS; k++) {
+            sub[k][plane[pixel + k]]++;
+        }
+    }
+    for (; pixel < size; pixel++) {
+        sub[0][plane[pixel]]++;
+    }
+
+    for (int value = 0; value < 256; value++) {
+        uint32_t count = 0;
+        for (int k = 0; k < SUB_HISTOGRAMS; k++) count += sub[k][value];
+        histogram[value] = count;
+    }
+}
+
+void histogram_summary(const uint64_t histogram[256], ChannelStats *stats) {
+    uint64_t count = 0;
+    double sum = 0, sumSquares = 0;
+    int min = -1, max = 0;
+
+    for (int value = 0; value < 256; value++) {
+        if (histogram[value] == 0) continue;
+        if (min < 0) min = value;
+        max = value;
+        count += histogram[value];
+        sum += (double)value * histogram[value];
+        sumSquares += (double)value * value * histogram[value];
+    }
+
+    stats->min = (unsigned char)(min < 0 ? 0 : min);
+    stats->max = (unsigned char)max;
+    stats->mean = count ? sum / count : 0;
+    double variance = count ? sumSquares / count - stats->mean * stats->mean
+                            : 0;
+    stats->stddev = variance > 0 ? sqrt(variance) : 0;
+}
+
+unsigned char histogram_percentile(const uint64_t histogram[256],
+        double fraction) {
+    uint64_t count = 0;
+    for (int value = 0; value < 256; value++) {
+        count += histogram[value];
+    }
+
+    uint64_t target = (uint64_t)(fraction * count);
+    uint64_t seen = 0;
+    for (int value = 0; value < 256; value++) {
+        seen += histogram[value];
+        if (seen > target) return (unsigned char)value;
+    }
+    return 255;
+}
+
+static void write_stats_json(FILE *outputFile, const ChannelStats *stats) {
+    fprintf(outputFile, "{\"min\": %d, \"max\": %d, \"mean\": %.3f, "
+        "\"stddev\": %.3f}", stats->min, stats->max,
+        stats->mean, stats->stddev);
+}
+
+void video_stats(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels) {
+    size_t channelSize = height * width;
+    size_t frameSize = channelSize * channels;
+    size_t batchSize = 256;  // Number of frames per batch
+    int numThreads = omp_get_max_threads();
+
+    unsigned char *batch = pool_acquire(batchSize * frameSize);
+    ChannelStats *frameStats = malloc(batchSize * channels *
+                                      sizeof(ChannelStats));
+    // Each thread accumulates the whole-file histograms privately
+    uint64_t *threadHistograms = calloc(numThreads * channels * 256,
+                                        sizeof(uint64_t));
+    if (!batch || !frameStats || !threadHistograms) {
+        perror("Error allocating memory");
+        pool_release(batch);
+        free(frameStats);
+        free(threadHistograms);
+        exit(1);
+    }
+
+    fprintf(outputFile, "{\n  \"frames\": %ld,\n  \"channels\": %d,\n"
+        "  \"height\": %d,\n  \"width\": %d,\n  \"per_frame\": [",
+        numFrames, channels, height, width);
+
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        if (fread(batch, frameSize, framesInBatch, inputFile)
+                != (size_t)framesInBatch) {
+            perror("Error reading frame data");
+            pool_release(batch);
+            free(frameStats);
+            free(threadHistograms);
+            exit(1);
+        }
+
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            uint64_t *fileHistograms = threadHistograms
+                + omp_get_thread_num() * channels * 256;
+            for (unsigned char ch = 0; ch < channels; ch++) {
+                uint32_t histogram[256];
+                uint64_t wideHistogram[256];
+                channel_histogram(batch + frame * frameSize
+                    + ch * channelSize, channelSize, histogram);
+                for (int value = 0; value < 256; value++) {
+                    wideHistogram[value] = histogram[value];
+                    fileHistograms[ch * 256 + value] += histogram[value];
+                }
+                histogram_summary(wideHistogram,
+                    &frameStats[frame * channels + ch]);
+            }
+        }
+
+        // Per-frame results are written in order once the batch is done
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            fprintf(outputFile, "%s\n    {\"frame\": %ld, \"channels\": [",
+                framesProcessed + frame == 0 ? "" : ",",
+                framesProcessed + frame);
+            for (unsigned char ch = 0; ch < channels; ch++) {
+                if (ch) fprintf(outputFile, ", ");
+                write_stats_json(outputFile, &frameStats[frame * channels
+                                                         + ch]);
+            }
+            fprintf(outputFile, "]}");
+        }
+    }
+
+    // Merge the per-thread histograms into the whole-file result
+    fprintf(outputFile, "\n  ],\n  \"file\": [");
+    for (unsigned char ch = 0; ch < channels; ch++) {
+        uint64_t histogram[256] = {0};
+        for (int t = 0; t < numThreads; t++) {
+            for (int value = 0; value < 256; value++) {
+                histogram[value] += threadHistograms[(t * channels + ch) * 256
+                                                     + value];
+            }
+        }
+
+        ChannelStats stats;
+        histogram_summary(histogram, &stats);
+        fprintf(outputFile, "%s\n    {\"channel\": %d, \"stats\": ",
+            ch ? "," : "", ch);
+        write_stats_json(outputFile, &stats);
+        // Suggested clip_channel bounds ignoring the outer 0.5% each side
+        fprintf(outputFile, ",\n     \"clip\": [%d, %d],\n     \"histogram\": [",
+            histogram_percentile(histogram, 0.005),
+            histogram_percentile(histogram, 0.995));
+        for (int value = 0; value < 256; value++) {
+            fprintf(outputFile, "%s%lu", value ? ", " : "", histogram[value]);
+        }
+        fprintf(outputFile, "]}");
+    }
+    fprintf(outputFile, "\n  ]\n}\n");
+
+    pool_release(batch);
+    free(frameStats);
+    free(threadHistograms);
+    printf("Statistics completed successfully.\n");
+}
+
+// Stretch [0.5%, 99.5%] of the histogram to the full range
+static void levels_lut(const uint64_t histogram[256],
+        unsigned char lookupTable[256]) {
+    int low = histogram_percentile(histogram, 0.005);
+    int high = histogram_percentile(histogram, 0.995);
+    for (int value = 0; value < 256; value++) {
+        if (high <= low) {
+            lookupTable[value] = (unsigned char)value;
+        } else if (value <= low) {
+            lookupTable[value] = 0;
+        } else if (value >= high) {
+            lookupTable[value] = 255;
+        } else {
+            lookupTable[value] = (unsigned char)(
+                ((value - low) * 255 + (high - low) / 2) / (high - low));
+        }
+    }
+}
+
+// Map each value through the normalised cumulative histogram
+static void equalize_lut(const uint64_t histogram[256],
+        unsigned char lookupTable[256]) {
+    uint64_t total = 0, cdfMin = 0, cdf = 0;
+    for (int value = 0; value < 256; value++) {
+        total += histogram[value];
+        if (cdfMin == 0) cdfMin = histogram[value];
+    }
+    for (int value = 0; value < 256; value++) {
+        cdf += histogram[value];
+        if (total == cdfMin) {
+            lookupTable[value] = (unsigned char)value;
+        } else if (cdf <= cdfMin) {
+            lookupTable[value] = 0;
+        } else {
+            lookupTable[value] = (unsigned char)(
+                ((cdf - cdfMin) * 255 + (total - cdfMin) / 2)
+                / (total - cdfMin));
+        }
+    }
+}
+
+// Whole-file histograms of the selected channels for a batch of frames
+static void accumulate_histograms(const unsigned char *frames,
+        int64_t count, size_t channelSize, unsigned char channels,
+        const bool *selected, uint64_t *threadHistograms) {
+    size_t frameSize = channelSize * channels;
+    #pragma omp parallel for schedule(static)
+    for (int64_t frame = 0; frame < count; frame++) {
+        uint64_t *histograms = threadHistograms
+            + omp_get_thread_num() * channels * 256;
+        for (unsigned char ch = 0; ch < channels; ch++) {
+            if (!selected[ch]) continue;
+            uint32_t histogram[256];
+            channel_histogram(frames + frame * frameSize + ch * channelSize,
+                channelSize, histogram);
+            for (int value = 0; value < 256; value++) {
+                histograms[ch * 256 + value] += histogram[value];
+            }
+        }
+    }
+}
+
+static void levels_video(FILE *inputFile, FILE *outputFile,
+        int64_t numFrames, unsigned char height, unsigned char width,
+        unsigned char channels, const char *channelStr, bool equalize) {
+    bool selected[256] = {false};
+    if (channelStr == NULL || strcmp(channelStr, "all") == 0) {
+        memset(selected, true, channels);
+    } else {
+        int channel = atoi(channelStr);
+        if (channel < 0 || channel >= channels) {
+            fprintf(stderr, "Error: Invalid channel index\n");
+            exit(1);
+        }
+        selected[channel] = true;
+    }
+
+    size_t channelSize = height * width;
+    size_t frameSize = channelSize * channels;
+    size_t fileSize = frameSize * numFrames;
+    size_t batchSize = 256;  // Number of frames per batch
+    int numThreads = omp_get_max_threads();
+
+    unsigned char *batch = pool_acquire(batchSize * frameSize);
+    uint64_t *threadHistograms = calloc(numThreads * channels * 256,
+                                        sizeof(uint64_t));
+    unsigned char (*lookupTables)[256] = malloc(channels * 256);
+    if (!batch || !threadHistograms || !lookupTables) {
+        perror("Error allocating memory");
+        pool_release(batch);
+        free(threadHistograms);
+        free(lookupTables);
+        exit(1);
+    }
+
+    // Map the input so the second pass is served from the page cache
+    off_t dataStart = ftello(inputFile);
+    unsigned char *mappedData = MAP_FAILED;
+    if (dataStart >= 0 && fileSize > 0) {
+        mappedData = mmap(NULL, dataStart + fileSize, PROT_READ, MAP_PRIVATE,
+                          fileno(inputFile), 0);
+    }
+    const unsigned char *inputData = mappedData == MAP_FAILED ? NULL
+                                     : mappedData + dataStart;
+
+    // First pass: read-only histogram of every selected channel
+    if (inputData) {
+        accumulate_histograms(inputData, numFrames, channelSize, channels,
+            selected, threadHistograms);
+    } else {
+        for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+                framesProcessed += batchSize) {
+            int64_t framesInBatch = numFrames - framesProcessed;
+            if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+            if (fread(batch, frameSize, framesInBatch, inputFile)
+                    != (size_t)framesInBatch) {
+                perror("Error reading frame data");
+                pool_release(batch);
+                free(threadHistograms);
+                free(lookupTables);
+                exit(1);
+            }
+            accumulate_histograms(batch, framesInBatch, channelSize,
+                channels, selected, threadHistograms);
+        }
+        if (fseeko(inputFile, dataStart, SEEK_SET) != 0) {
+            perror("Error rewinding input, a seekable file is required");
+            pool_release(batch);
+            free(threadHistograms);
+            free(lookupTables);
+            exit(1);
+        }
+    }
+
+    // Build one lookup table per selected channel from the merged histogram
+    for (unsigned char ch = 0; ch < channels; ch++) {
+        if (!selected[ch]) continue;
+        uint64_t histogram[256] = {0};
+        for (int t = 0; t < numThreads; t++) {
+            for (int value = 0; value < 256; value++) {
+                histogram[value] += threadHistograms[(t * channels + ch) * 256
+                                                     + value];
+            }
+        }
+        if (equalize) {
+            equalize_lut(histogram, lookupTables[ch]);
+        } else {
+            levels_lut(histogram, lookupTables[ch]);
+            printf("Channel %d levels: [%d,%d] -> [0,255]\n", ch,
+                histogram_percentile(histogram, 0.005),
+                histogram_percentile(histogram, 0.995));
+        }
+    }
+
+    // Second pass: apply the tables frame by frame
+    for (int64_t framesProcessed = 0; framesProcessed < numFrames;
+            framesProcessed += batchSize) {
+        int64_t framesInBatch = numFrames - framesProcessed;
+        if (framesInBatch > (int64_t)batchSize) framesInBatch = batchSize;
+
+        const unsigned char *source;
+        if (inputData) {
+            source = inputData + framesProcessed * frameSize;
+        } else {
+            if (fread(batch, frameSize, framesInBatch, inputFile)
+                    != (size_t)framesInBatch) {
+                perror("Error reading frame data");
+                pool_release(batch);
+                free(threadHistograms);
+                free(lookupTables);
+                exit(1);
+            }
+            source = batch;
+        }
+
+        #pragma omp parallel for schedule(static)
+        for (int64_t frame = 0; frame < framesInBatch; frame++) {
+            for (unsigned char ch = 0; ch < channels; ch++) {
+                size_t offset = frame * frameSize + ch * channelSize;
+                if (selected[ch]) {
+                    apply_lut(source + offset, batch + offset, channelSize,
+                        lookupTables[ch]);
+                } else if (source != batch) {
+                    memcpy(batch + offset, source + offset, channelSize);
+                }
+            }
+        }
+
+        if (fwrite(batch, frameSize, framesInBatch, outputFile)
+                != (size_t)framesInBatch) {
+            perror("Error writing frame data");
+            pool_release(batch);
+            free(threadHistograms);
+            free(lookupTables);
+            exit(1);
+        }
+    }
+
+    if (mappedData != MAP_FAILED) {
+        munmap(mappedData, dataStart + fileSize);
+    }
+    pool_release(batch);
+    free(threadHistograms);
+    free(lookupTables);
+}
+
+void auto_levels(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        const char *channelStr) {
+    levels_video(inputFile, outputFile, numFrames, height, width, channels,
+        channelStr, false);
+    printf("Auto levels completed successfully.\n");
+}
+
+void equalize(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+        unsigned char height, unsigned char width, unsigned char channels,
+        const char *channelStr) {
+    levels_video(inputFile, outputFile, numFrames, height, width, channels,
+        channelStr, true);
+    printf("Histogram equalisation completed successfully.\n");
+}
@@ -0,0 +1,27 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_STATS_H
+#define LIB_FILMMASTER2000_STATS_H
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct {
+    unsigned char min;
+    unsigned char max;
+    double mean;
+    double stddev;
+} ChannelStats;
+
+void channel_histogram(const unsigned char *plane, size_t size,
+    uint32_t histogram[256]);
+void histogram_summary(const uint64_t histogram[256], ChannelStats *stats);
+unsigned char histogram_percentile(const uint64_t histogram[256],
+    double fraction);
+void video_stats(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels);
+void auto_levels(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels,
+    const char *channelStr);
+void equalize(FILE *inputFile, FILE *outputFile, int64_t numFrames,
+    unsigned char height, unsigned char width, unsigned char channels,
+    const char *channelStr);
+#endif
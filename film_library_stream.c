@@ -0,0 +1,199 @@
+// Copyright 2025 Rose Laird
+
+#define _GNU_SOURCE  // for fopencookie
+
+#include <stdio.h>
+#include <stdlib.h>  // for calloc, free, exit, getenv, mkstemp
+#include <string.h>  // for memcpy
+#include <stdint.h>  // for int64_t type
+#include <stdbool.h>  // for boolean type
+#include <errno.h>  // for errno
+#include <unistd.h>  // for lseek, write, unlink, close
+#include "film_library_pool.h"  // for pool_acquire, pool_release
+#include "film_library_stream.h"
+
+#define COPY_CHUNK (1 << 20)
+
+typedef struct {
+    int fd;
+    VideoMetadata header;  // held until the first frame byte
+    bool headerSent;
+    int64_t position;  // write position in the operation's stream
+} StreamOutput;
+
+bool is_seekable(FILE *file) {
+    int fd = fileno(file);
+    return fd == -1 || lseek(fd, 0, SEEK_CUR) != -1;
+}
+
+static FILE *open_temp_file(void) {
+    const char *directory = getenv("TMPDIR");
+    if (!directory || !*directory) directory = "/tmp";
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/filmmaster2000-XXXXXX", directory);
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        perror("Error creating temporary file");
+        exit(1);
+    }
+    // Only the descriptor keeps it alive, so it goes away on any exit
+    unlink(path);
+    FILE *file = fdopen(fd, "w+b");
+    if (!file) {
+        perror("Error creating temporary file");
+        close(fd);
+        exit(1);
+    }
+    return file;
+}
+
+// Copy from the current position of src to the end
+static void copy_to_end(FILE *src, FILE *dst) {
+    unsigned char *buffer = pool_acquire(COPY_CHUNK);
+    if (!buffer) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    size_t chunk;
+    while ((chunk = fread(buffer, 1, COPY_CHUNK, src)) > 0) {
+        if (fwrite(buffer, 1, chunk, dst) != chunk) {
+            perror("Error copying frame data");
+            pool_release(buffer);
+            exit(1);
+        }
+    }
+    pool_release(buffer);
+    if (ferror(src)) {
+        perror("Error copying frame data");
+        exit(1);
+    }
+}
+
+FILE *spill_input(FILE *inputFile, const VideoMetadata *metadata) {
+    FILE *spill = open_temp_file();
+    // Keep the header so offsets, and a compressed input's index, match
+    if (fwrite(metadata, sizeof(VideoMetadata), 1, spill) != 1) {
+        perror("Error writing temporary file");
+        exit(1);
+    }
+    copy_to_end(inputFile, spill);
+    fclose(inputFile);
+    if (fflush(spill) != 0
+            || fseeko(spill, sizeof(VideoMetadata), SEEK_SET) != 0) {
+        perror("Error writing temporary file");
+        exit(1);
+    }
+    return spill;
+}
+
+static int write_all(int fd, const char *buf, size_t size) {
+    while (size > 0) {
+        ssize_t put = write(fd, buf, size);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return -1;
+        buf += put;
+        size -= put;
+    }
+    return 0;
+}
+
+static ssize_t stream_output_write(void *cookie, const char *buf,
+        size_t size) {
+    StreamOutput *output = cookie;
+    size_t written = 0;
+
+    if (output->position < (int64_t)sizeof(VideoMetadata)) {
+        written = sizeof(VideoMetadata) - output->position;
+        if (written > size) written = size;
+        memcpy((char *)&output->header + output->position, buf, written);
+        output->position += written;
+    }
+    if (written == size) return written;
+
+    if (!output->headerSent) {
+        if (write_all(output->fd, (const char *)&output->header,
+                      sizeof(VideoMetadata)) != 0) {
+            return -1;
+        }
+        output->headerSent = true;
+    }
+    if (write_all(output->fd, buf + written, size - written) != 0) {
+        return -1;
+    }
+    output->position += size - written;
+    return size;
+}
+
+static int stream_output_seek(void *cookie, off64_t *offset, int whence) {
+    StreamOutput *output = cookie;
+    int64_t target = *offset;
+    if (whence == SEEK_CUR) target += output->position;
+    // Once frames have gone down the pipe only staying put is possible
+    if (whence == SEEK_END || target < 0
+            || (target != output->position
+                && (output->headerSent
+                    || target > (int64_t)sizeof(VideoMetadata)))) {
+        errno = ESPIPE;
+        return -1;
+    }
+    output->position = target;
+    *offset = target;
+    return 0;
+}
+
+static int stream_output_close(void *cookie) {
+    StreamOutput *output = cookie;
+    int status = 0;
+    // Videos without frames still need their header
+    if (!output->headerSent
+            && write_all(output->fd, (const char *)&output->header,
+                         sizeof(VideoMetadata)) != 0) {
+        status = -1;
+    }
+    if (close(output->fd) != 0) status = -1;
+    free(output);
+    return status;
+}
+
+FILE *open_stream_output(int fd) {
+    StreamOutput *output = calloc(1, sizeof(StreamOutput));
+    if (!output) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    output->fd = fd;
+
+    cookie_io_functions_t functions = {
+        .read = NULL,
+        .write = stream_output_write,
+        .seek = stream_output_seek,
+        .close = stream_output_close,
+    };
+    FILE *file = fopencookie(output, "wb", functions);
+    if (!file) {
+        perror("Error opening output stream");
+        exit(1);
+    }
+    return file;
+}
+
+FILE *open_spill_output(void) {
+    return open_temp_file();
+}
+
+int close_spill_output(FILE *spill, int fd) {
+    FILE *stream = fdopen(fd, "wb");
+    if (!stream) {
+        fclose(spill);
+        close(fd);
+        return -1;
+    }
+    if (fflush(spill) != 0 || fseeko(spill, 0, SEEK_SET) != 0) {
+        fclose(spill);
+        fclose(stream);
+        return -1;
+    }
+    copy_to_end(spill, stream);
+    fclose(spill);
+    return fclose(stream);
+}
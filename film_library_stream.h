@@ -0,0 +1,23 @@
+// Copyright 2025 Rose Laird
+#ifndef LIB_FILMMASTER2000_STREAM_H
+#define LIB_FILMMASTER2000_STREAM_H
+#include <stdio.h>
+#include <stdbool.h>
+#include "film_library.h"
+
+// False for pipes and terminals, which can only be read or written in order
+bool is_seekable(FILE *file);
+// Copies the header and the rest of a pipe to an unlinked temporary file
+// for operations that seek or map their input, through one fixed size
+// buffer. Takes ownership of inputFile and returns the copy positioned
+// after the header.
+FILE *spill_input(FILE *inputFile, const VideoMetadata *metadata);
+// Writes to a pipe, holding the header back until the first frame so the
+// operation can still rewrite it (new frame count or resolution) up to
+// that point. Takes ownership of fd.
+FILE *open_stream_output(int fd);
+// Temporary file for output whose header is only known at the end
+FILE *open_spill_output(void);
+// Sends everything written to a spill output down fd, then closes both
+int close_spill_output(FILE *spill, int fd);
+#endif
@@ -0,0 +1,229 @@
+"""Python bindings for libFilmMaster2000.so (build it with make).
+
+Files are memory mapped and frames are handed out as memoryviews of the
+mapping, so nothing is copied: numpy.asarray(video.frame(i)) is a
+(channels, height, width) array over the file, or (height, width,
+channels) for packed files. Library calls run in place
+on any writable buffer and, being ctypes calls, release the GIL, so
+threads calling into the library run in parallel.
+
+    with Video('input.bin') as video:
+        video.clip_channel(1, 10, 200)
+        histograms = video.histogram()
+"""
+
+import ctypes
+import mmap
+import os
+import sys
+
+ABI_VERSION = 1
+FORMAT_PACKED = 0x10
+FORMAT_COMPRESSED = 0x80
+
+
+class VideoInfo(ctypes.Structure):
+    _fields_ = [
+        ('numFrames', ctypes.c_int64),
+        ('format', ctypes.c_int32),
+        ('channels', ctypes.c_int32),
+        ('height', ctypes.c_int32),
+        ('width', ctypes.c_int32),
+        ('frameSize', ctypes.c_int64),
+        ('dataOffset', ctypes.c_int64),
+    ]
+
+
+def _load_library():
+    path = os.environ.get('FM_LIBRARY', os.path.join(
+        os.path.dirname(os.path.abspath(__file__)), 'libFilmMaster2000.so'))
+    library = ctypes.CDLL(path)  # CDLL drops the GIL around each call
+    info = ctypes.POINTER(VideoInfo)
+    pixels = ctypes.c_void_p
+    library.fm_abi_version.restype = ctypes.c_int32
+    library.fm_abi_version.argtypes = []
+    library.fm_read_header.restype = ctypes.c_int32
+    library.fm_read_header.argtypes = [pixels, ctypes.c_size_t, info]
+    library.fm_clip_channel.restype = ctypes.c_int32
+    library.fm_clip_channel.argtypes = [pixels, ctypes.c_int64, info,
+                                        ctypes.c_int32, ctypes.c_int32,
+                                        ctypes.c_int32]
+    library.fm_scale_channel.restype = ctypes.c_int32
+    library.fm_scale_channel.argtypes = [pixels, ctypes.c_int64, info,
+                                         ctypes.c_int32, ctypes.c_float]
+    library.fm_swap_channels.restype = ctypes.c_int32
+    library.fm_swap_channels.argtypes = [pixels, ctypes.c_int64, info,
+                                         ctypes.c_int32, ctypes.c_int32]
+    library.fm_histogram.restype = ctypes.c_int32
+    library.fm_histogram.argtypes = [pixels, ctypes.c_int64, info,
+                                     ctypes.POINTER(ctypes.c_uint64)]
+    library.fm_interleave.restype = ctypes.c_int32
+    library.fm_interleave.argtypes = [pixels, pixels, info]
+    if library.fm_abi_version() != ABI_VERSION:
+        raise ImportError(f'{path} has ABI version '
+                          f'{library.fm_abi_version()}, expected '
+                          f'{ABI_VERSION}')
+    return library
+
+
+_library = _load_library()
+
+
+class _Pointer:
+    """Address of a writable buffer, held for the length of a call."""
+
+    def __init__(self, buffer, offset=0):
+        self._array = ctypes.c_ubyte.from_buffer(buffer, offset)
+
+    def __enter__(self):
+        return ctypes.addressof(self._array)
+
+    def __exit__(self, *exc):
+        del self._array  # release the export so mmap.close() can work
+
+
+def _check(status, what):
+    if status != 0:
+        raise ValueError(f'{what} failed, check the channels and format')
+
+
+class Video:
+    """A memory mapped FilmMaster2000 file.
+
+    mode 'c' (default) maps privately: kernels change the frames in
+    memory only, and only the pages they touch are copied. mode 'r+'
+    writes changes back to the file.
+    """
+
+    def __init__(self, path, mode='c'):
+        access = mmap.ACCESS_WRITE if mode == 'r+' else mmap.ACCESS_COPY
+        with open(path, 'r+b' if mode == 'r+' else 'rb') as file:
+            self._map = mmap.mmap(file.fileno(), 0, access=access)
+        self.info = VideoInfo()
+        with _Pointer(self._map) as address:
+            _check(_library.fm_read_header(address, len(self._map),
+                                           ctypes.byref(self.info)),
+                   'Reading the header')
+        end = self.info.dataOffset + self.num_frames * self.info.frameSize
+        if self.info.format & FORMAT_COMPRESSED:
+            self._map.close()
+            raise ValueError(f'{path} is compressed, run runme decompress')
+        if len(self._map) < end:
+            self._map.close()
+            raise ValueError(f'{path} is shorter than its header says')
+
+    num_frames = property(lambda self: self.info.numFrames)
+    channels = property(lambda self: self.info.channels)
+    height = property(lambda self: self.info.height)
+    width = property(lambda self: self.info.width)
+    packed = property(lambda self: bool(self.info.format & FORMAT_PACKED))
+
+    def __len__(self):
+        return self.num_frames
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def close(self):
+        """Unmaps the file. Views from frame() must be released first."""
+        self._map.close()
+
+    def _range(self, start, stop):
+        stop = self.num_frames if stop is None else min(stop, self.num_frames)
+        if not 0 <= start < stop:
+            raise IndexError('empty frame range or outside the video')
+        return start, stop
+
+    def _offset(self, frame):
+        return self.info.dataOffset + frame * self.info.frameSize
+
+    def frame(self, index):
+        """Zero-copy view of one frame, shaped (channels, height, width),
+        or (height, width, channels) when packed."""
+        if not 0 <= index < self.num_frames:
+            raise IndexError('frame outside the video')
+        view = memoryview(self._map)[self._offset(index):
+                                     self._offset(index + 1)]
+        if self.info.frameSize != self.channels * self.height * self.width:
+            return view  # subsampled chroma has no single shape
+        if self.packed:
+            return view.cast('B', (self.height, self.width, self.channels))
+        return view.cast('B', (self.channels, self.height, self.width))
+
+    def clip_channel(self, channel, low, high, start=0, stop=None):
+        start, stop = self._range(start, stop)
+        with _Pointer(self._map, self._offset(start)) as address:
+            _check(_library.fm_clip_channel(address, stop - start,
+                                            ctypes.byref(self.info),
+                                            channel, low, high),
+                   'clip_channel')
+
+    def scale_channel(self, channel, factor, start=0, stop=None):
+        start, stop = self._range(start, stop)
+        with _Pointer(self._map, self._offset(start)) as address:
+            _check(_library.fm_scale_channel(address, stop - start,
+                                             ctypes.byref(self.info),
+                                             channel, factor),
+                   'scale_channel')
+
+    def swap_channels(self, channel1, channel2, start=0, stop=None):
+        start, stop = self._range(start, stop)
+        with _Pointer(self._map, self._offset(start)) as address:
+            _check(_library.fm_swap_channels(address, stop - start,
+                                             ctypes.byref(self.info),
+                                             channel1, channel2),
+                   'swap_channels')
+
+    def histogram(self, start=0, stop=None):
+        """256 pixel counts per channel, as a list of lists. Planar only."""
+        start, stop = self._range(start, stop)
+        counts = (ctypes.c_uint64 * (self.channels * 256))()
+        with _Pointer(self._map, self._offset(start)) as address:
+            _check(_library.fm_histogram(address, stop - start,
+                                         ctypes.byref(self.info), counts),
+                   'histogram')
+        return [list(counts[c * 256:(c + 1) * 256])
+                for c in range(self.channels)]
+
+    def interleaved(self, index, out=None):
+        """Frame index as height x width x channels bytes, e.g. for
+        PIL.Image.frombytes. out may be any writable buffer to reuse."""
+        if not 0 <= index < self.num_frames:
+            raise IndexError('frame outside the video')
+        size = self.channels * self.height * self.width
+        if out is None:
+            out = bytearray(size)
+        with memoryview(out) as view:
+            usable = not view.readonly and view.nbytes >= size
+        if not usable:
+            raise ValueError(f'out must be a writable buffer of at least '
+                             f'{size} bytes')
+        with _Pointer(self._map, self._offset(index)) as frame, \
+                _Pointer(out) as pixels:
+            _check(_library.fm_interleave(frame, pixels,
+                                          ctypes.byref(self.info)),
+                   'interleave')
+        return out
+
+
+def main(argv):
+    if len(argv) != 2:
+        print(f'Usage: {argv[0]} <video file>', file=sys.stderr)
+        return 1
+    with Video(argv[1]) as video:
+        print(f'Frames: {video.num_frames}, Channels: {video.channels}, '
+              f'Height: {video.height}, Width: {video.width}')
+        if not video.packed and video.info.frameSize == (
+                video.channels * video.height * video.width):
+            for channel, counts in enumerate(video.histogram()):
+                total = sum(counts)
+                mean = sum(v * n for v, n in enumerate(counts)) / total
+                print(f'Channel {channel} mean: {mean:.2f}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -5,17 +5,38 @@
 #include <string.h>  // for strcmp, sscanf
 #include <sys/time.h>  // for gettimeofday
 #include <sys/resource.h>  // for getrusage
+#include <unistd.h>  // for dup, dup2, lseek
 #include "film_library.h"  // for function declarations
 #include "film_library_plus.h"  // for extra functions
+#include "film_library_filter.h"  // for convolution filters
+#include "film_library_stats.h"  // for histograms and statistics
+#include "film_library_colour.h"  // for colour space conversion
+#include "film_library_scene.h"  // for scene cuts and duplicate frames
+#include "film_library_codec.h"  // for the compressed container
+#include "film_library_edit.h"  // for trim, concat and splice
+#include "film_library_edl.h"  // for edit decision lists
+#include "film_library_reader.h"  // for random access to frames
+#include "film_library_pool.h"  // for pool_trim and the high-water mark
+#include "film_library_shard.h"  // for splitting a job by frame range
+#include "film_library_rotate.h"  // for rotate, flip and transpose
+#include "film_library_composite.h"  // for crossfade and overlay
+#include "film_library_stream.h"  // for pipes on stdin and stdout
+#include "film_library_layout.h"  // for packed pixel frames
 #include <stdint.h>  // for int64_t type
+#include <inttypes.h>  // for SCNd64
+#include <stdbool.h>  // for boolean type
 #include <emmintrin.h>  // SSE2 intrinsics
 
 
 void print_usage() {
     // Print usage information and ends program on incorrect input
     fprintf(stderr,
-        "Usage: ./runme [input file] [output file] [-S/-M] [function] "
-        "[options]\n");
+        "Usage: ./runme [input file] [output file] [--frames start:end] "
+        "[-S/-M] [function] [options]\n");
+    fprintf(stderr, "  - as the input or output file reads stdin or writes "
+        "stdout, messages then go to stderr\n");
+    fprintf(stderr, "  --frames <start:end> writes one slice of a shared "
+        "output, --frames finalize then writes its header\n");
     fprintf(stderr, "Functions and options:\n");
     fprintf(stderr, "  reverse\n");
     fprintf(stderr, "  swap_channel <channel1> <channel2>\n");
@@ -23,6 +44,134 @@ void print_usage() {
     fprintf(stderr, "  scale_channel <channel> <factor>\n");
     fprintf(stderr, "  speed_up <factor>\n");
     fprintf(stderr, "  crop_aspect <aspect ratio>\n");
+    fprintf(stderr, "  resize <width>x<height> [bilinear|box]\n");
+    fprintf(stderr, "  rotate <90|180|270> (clockwise)\n");
+    fprintf(stderr, "  flip <h|v>\n");
+    fprintf(stderr, "  transpose\n");
+    fprintf(stderr, "  filter <gaussian|sharpen> <sigma|amount>\n");
+    fprintf(stderr, "  temporal_denoise <radius> [mean|median]\n");
+    fprintf(stderr, "  stats (output file receives JSON)\n");
+    fprintf(stderr, "  auto_levels <channel|all>\n");
+    fprintf(stderr, "  equalize [channel|all]\n");
+    fprintf(stderr, "  to_yuv [444|420] [601|709]\n");
+    fprintf(stderr, "  to_rgb\n");
+    fprintf(stderr, "  to_packed\n");
+    fprintf(stderr, "  to_planar\n");
+    fprintf(stderr, "  scene_index [threshold] (output file receives JSON)\n");
+    fprintf(stderr, "  dedupe <threshold>\n");
+    fprintf(stderr, "  compress [gop size]\n");
+    fprintf(stderr, "  decompress\n");
+    fprintf(stderr, "  trim <start> <end>\n");
+    fprintf(stderr, "  concat <clip> [clip ...]\n");
+    fprintf(stderr, "  splice <start> <end> <clip>\n");
+    fprintf(stderr, "  crossfade <clip> <frames>\n");
+    fprintf(stderr, "  overlay <top> <alpha 0-1|alpha-channel>\n");
+    fprintf(stderr, "  render <edit list>\n");
+    fprintf(stderr, "  frames <frame,frame,...>\n");
+    fprintf(stderr, "  proxies <levels> (level n > 1 goes to output_n)\n");
+}
+
+int writes_video(const char *function) {
+    // Analysis functions write a report instead of a video
+    return strcmp(function, "stats") != 0
+        && strcmp(function, "scene_index") != 0;
+}
+
+int reads_subsampled(const char *function) {
+    // Everything else assumes full resolution planes
+    return strcmp(function, "to_rgb") == 0
+        || strcmp(function, "compress") == 0
+        || strcmp(function, "decompress") == 0
+        || strcmp(function, "trim") == 0
+        || strcmp(function, "concat") == 0
+        || strcmp(function, "splice") == 0
+        || strcmp(function, "render") == 0
+        || strcmp(function, "frames") == 0;
+}
+
+int reads_packed(const char *function) {
+    // Per-channel operations have packed versions, the rest move or
+    // compare whole frames, which works in either layout
+    return strcmp(function, "to_planar") == 0
+        || strcmp(function, "swap_channel") == 0
+        || strcmp(function, "clip_channel") == 0
+        || strcmp(function, "scale_channel") == 0
+        || strcmp(function, "reverse") == 0
+        || strcmp(function, "speed_up") == 0
+        || strcmp(function, "scene_index") == 0
+        || strcmp(function, "dedupe") == 0
+        || strcmp(function, "compress") == 0
+        || strcmp(function, "decompress") == 0
+        || strcmp(function, "trim") == 0
+        || strcmp(function, "concat") == 0
+        || strcmp(function, "splice") == 0
+        || strcmp(function, "crossfade") == 0
+        || strcmp(function, "frames") == 0;
+}
+
+int needs_random_access(const char *function) {
+    // These seek or map their input, so a pipe is first copied to a file
+    return strcmp(function, "reverse") == 0
+        || strcmp(function, "auto_levels") == 0
+        || strcmp(function, "equalize") == 0
+        || strcmp(function, "trim") == 0
+        || strcmp(function, "concat") == 0
+        || strcmp(function, "splice") == 0
+        || strcmp(function, "render") == 0
+        || strcmp(function, "frames") == 0;
+}
+
+int writes_header_last(const char *function) {
+    // The frame count is only known once every frame has been written
+    return strcmp(function, "dedupe") == 0;
+}
+
+int plan_shard(const char *function, char **params, int param_count,
+        int64_t numFrames, int64_t start, int64_t end, ShardPlan *plan) {
+    // Only operations making each output frame from one input frame can
+    // be split, the rest need the whole file
+    if (start < 0 || start > end) return -1;
+    if (end > numFrames) end = numFrames;
+    if (start > end) start = end;
+    plan->inputStart = start;
+    plan->inputEnd = end;
+    plan->outputStart = start;
+    plan->outputFrames = end - start;
+    plan->totalFrames = numFrames;
+
+    if (strcmp(function, "reverse") == 0) {
+        plan->outputStart = numFrames - end;
+    } else if (strcmp(function, "speed_up") == 0) {
+        int64_t factor = param_count == 1 ? atoi(params[0]) : 0;
+        if (factor <= 1) return -1;
+        // Kept frames are the multiples of factor, round both ends up to one
+        plan->inputStart = (start + factor - 1) / factor * factor;
+        plan->inputEnd = (end + factor - 1) / factor * factor;
+        if (plan->inputEnd > numFrames) plan->inputEnd = numFrames;
+        if (plan->inputStart > plan->inputEnd) {
+            plan->inputStart = plan->inputEnd;
+        }
+        plan->outputStart = speed_up_frames(plan->inputStart, factor);
+        plan->outputFrames = speed_up_frames(plan->inputEnd, factor)
+                           - plan->outputStart;
+        plan->totalFrames = speed_up_frames(numFrames, factor);
+    } else if (strcmp(function, "swap_channel") != 0
+            && strcmp(function, "clip_channel") != 0
+            && strcmp(function, "scale_channel") != 0
+            && strcmp(function, "crop_aspect") != 0
+            && strcmp(function, "resize") != 0
+            && strcmp(function, "rotate") != 0
+            && strcmp(function, "flip") != 0
+            && strcmp(function, "transpose") != 0
+            && strcmp(function, "filter") != 0
+            && strcmp(function, "to_yuv") != 0
+            && strcmp(function, "to_rgb") != 0
+            && strcmp(function, "to_packed") != 0
+            && strcmp(function, "to_planar") != 0
+            && strcmp(function, "decompress") != 0) {
+        return -1;
+    }
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
@@ -41,31 +190,63 @@ int main(int argc, char *argv[]) {
     // Parse command line arguments
     char *inputFilePath = argv[1];
     char *outputFilePath = argv[2];
+    char *frameRange = NULL;
     char *mode = NULL;
-    char *function = NULL;
-    char **params = NULL;
-    int param_count = argc - 5;
-
-    if (strcmp(argv[3], "-S") == 0 || strcmp(argv[3], "-M") == 0) {
-        mode = argv[3];
-        function = argv[4];
-        params = &argv[5];  // Options start from the 5th index
-    } else {
-        function = argv[3];
-        params = &argv[4];  // Options start from the 4th index
-        param_count += 1;
+    int arg = 3;
+    if (strcmp(argv[arg], "--frames") == 0 && arg + 1 < argc) {
+        frameRange = argv[arg + 1];
+        arg += 2;
+    }
+    if (arg < argc
+            && (strcmp(argv[arg], "-S") == 0 || strcmp(argv[arg], "-M") == 0)) {
+        mode = argv[arg++];
     }
+    if (arg >= argc) {
+        print_usage();
+        return 1;
+    }
+    char *function = argv[arg];
+    char **params = &argv[arg + 1];  // Options follow the function
+    int param_count = argc - arg - 1;
 
-    FILE *inputFile = fopen(inputFilePath, "rb");
-    if (!inputFile) {
-        perror("Error opening input file");
+    // A worker handles frames [start, end) of a sharded job, finalize
+    // writes the header once every worker is done
+    int64_t shardStart = 0, shardEnd = 0;
+    bool finalize = frameRange && strcmp(frameRange, "finalize") == 0;
+    if (frameRange && !finalize
+            && sscanf(frameRange, "%" SCNd64 ":%" SCNd64,
+                      &shardStart, &shardEnd) != 2) {
+        print_usage();
         return 1;
     }
 
-    FILE *outputFile = fopen(outputFilePath, "wb");
-    if (!outputFile) {
-        perror("Error opening output file");
-        fclose(inputFile);
+    // "-" streams through stdin or stdout, e.g. between runme stages
+    bool streamInput = strcmp(inputFilePath, "-") == 0;
+    bool streamOutput = strcmp(outputFilePath, "-") == 0;
+    if (frameRange && (streamInput || streamOutput)) {
+        fprintf(stderr, "Error: --frames needs an input and output file, "
+            "not -.\n");
+        return 1;
+    }
+    if (streamOutput && strcmp(function, "proxies") == 0) {
+        fprintf(stderr, "Error: proxies writes several files, "
+            "give an output file rather than -.\n");
+        return 1;
+    }
+    int outputFd = -1;
+    if (streamOutput) {
+        // Frames keep the real stdout, messages go to stderr instead
+        fflush(stdout);
+        outputFd = dup(STDOUT_FILENO);
+        if (outputFd == -1 || dup2(STDERR_FILENO, STDOUT_FILENO) == -1) {
+            perror("Error redirecting stdout");
+            return 1;
+        }
+    }
+
+    FILE *inputFile = streamInput ? stdin : fopen(inputFilePath, "rb");
+    if (!inputFile) {
+        perror("Error opening input file");
         return 1;
     }
 
@@ -74,12 +255,79 @@ int main(int argc, char *argv[]) {
     if (fread(&metadata, sizeof(VideoMetadata), 1, inputFile) != 1) {
         perror("Error reading video metadata");
         fclose(inputFile);
-        fclose(outputFile);
+        return 1;
+    }
+
+    // A pipe can only be read once, in order
+    if (needs_random_access(function) && !is_seekable(inputFile)) {
+        inputFile = spill_input(inputFile, &metadata);
+    }
+    // Functions opening the input by name get the descriptor's path
+    char streamPath[64];
+    if (streamInput) {
+        snprintf(streamPath, sizeof(streamPath), "/proc/self/fd/%d",
+            fileno(inputFile));
+        inputFilePath = streamPath;
+    }
+
+    // Compressed input is decoded on the fly behind a normal FILE
+    if (metadata.format & FORMAT_COMPRESSED) {
+        inputFile = open_compressed_input(inputFile, &metadata);
+    }
+
+    if ((metadata.format & FORMAT_CHROMA_MASK) != FORMAT_CHROMA_444
+            && !reads_subsampled(function)) {
+        fprintf(stderr, "Error: %s needs full resolution planes, "
+            "convert 4:2:0 input with to_rgb first.\n", function);
+        fclose(inputFile);
+        return 1;
+    }
+    bool packed = metadata.format & FORMAT_PACKED;
+    if (packed && !reads_packed(function)) {
+        fprintf(stderr, "Error: %s needs planar frames, "
+            "convert packed input with to_planar first.\n", function);
+        fclose(inputFile);
+        return 1;
+    }
+
+    FILE *outputFile;
+    bool spillOutput = false;
+    ShardPlan plan;
+    VideoMetadata shardHeader;
+    if (frameRange) {
+        if (plan_shard(function, params, param_count, metadata.numFrames,
+                shardStart, shardEnd, &plan) != 0) {
+            fprintf(stderr, "Error: %s cannot be split by frame range.\n",
+                function);
+            fclose(inputFile);
+            return 1;
+        }
+        // The operation sees only its slice, finalizing sees no frames
+        if (finalize) plan.inputStart = plan.inputEnd = 0;
+        inputFile = open_shard_input(inputFile, &metadata, plan.inputStart,
+            plan.inputEnd);
+        outputFile = open_shard_output(outputFilePath, &plan, &shardHeader);
+    } else if (streamOutput && (!writes_video(function)
+            || lseek(outputFd, 0, SEEK_CUR) != -1)) {
+        // Reports and stdout redirected to a file need nothing special
+        outputFile = fdopen(outputFd, "wb");
+    } else if (streamOutput && writes_header_last(function)) {
+        outputFile = open_spill_output();
+        spillOutput = true;
+    } else if (streamOutput) {
+        outputFile = open_stream_output(outputFd);
+    } else {
+        outputFile = fopen(outputFilePath, "wb");
+    }
+    if (!outputFile) {
+        perror("Error opening output file");
+        fclose(inputFile);
         return 1;
     }
 
     // Writes video metadata
-    if (fwrite(&metadata, sizeof(VideoMetadata), 1, outputFile) != 1) {
+    if (writes_video(function) &&
+            fwrite(&metadata, sizeof(VideoMetadata), 1, outputFile) != 1) {
         perror("Error writing video metadata");
         fclose(inputFile);
         fclose(outputFile);
@@ -113,7 +361,9 @@ int main(int argc, char *argv[]) {
             fclose(outputFile);
             return 1;
         }
-        if (mode && strcmp(mode, "-S") == 0) {
+        if (packed) {
+            swap_channel_packed(inputFile, outputFile, &metadata, ch1, ch2);
+        } else if (mode && strcmp(mode, "-S") == 0) {
             swap_channel_fast(inputFile, outputFile, ch1, ch2,
                 metadata.numFrames, metadata.height,
                 metadata.width, metadata.channels);
@@ -143,7 +393,10 @@ int main(int argc, char *argv[]) {
             fclose(outputFile);
             return 1;
         }
-        if (mode && strcmp(mode, "-S") == 0) {
+        if (packed) {
+            clip_channel_packed(inputFile, outputFile, &metadata, channel,
+                min, max);
+        } else if (mode && strcmp(mode, "-S") == 0) {
             clip_channel_fast(inputFile, outputFile, channel, min, max,
                 metadata.numFrames, metadata.height,
                 metadata.width, metadata.channels);
@@ -167,7 +420,10 @@ int main(int argc, char *argv[]) {
         // Parse channel number and scaling factor
         unsigned char channel = (unsigned char)atoi(params[0]);
         float factor = atof(params[1]);
-        if (mode && strcmp(mode, "-S") == 0) {
+        if (packed) {
+            scale_channel_packed(inputFile, outputFile, &metadata, channel,
+                factor);
+        } else if (mode && strcmp(mode, "-S") == 0) {
             scale_channel_fast(inputFile, outputFile, channel,
                 factor, metadata.numFrames, metadata.height,
                 metadata.width, metadata.channels);
@@ -201,6 +457,224 @@ int main(int argc, char *argv[]) {
         // Crop video frames to a target aspect ratio with extracted ratio
         crop_aspect_ratio(inputFile, outputFile, metadata.numFrames,
                 metadata.width, metadata.height, metadata.channels, params[0]);
+    } else if (strcmp(function, "resize") == 0) {
+        if (param_count != 1 && param_count != 2) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Resample every channel plane to the new resolution
+        resize(inputFile, outputFile, metadata.numFrames, metadata.height,
+            metadata.width, metadata.channels, params[0],
+            param_count == 2 ? params[1] : NULL);
+    } else if (strcmp(function, "rotate") == 0
+            || strcmp(function, "flip") == 0) {
+        if (param_count != 1) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Every plane is rewritten through cache-sized transposed tiles
+        if (strcmp(function, "rotate") == 0) {
+            rotate(inputFile, outputFile, metadata.numFrames,
+                metadata.height, metadata.width, metadata.channels,
+                atoi(params[0]));
+        } else {
+            flip(inputFile, outputFile, metadata.numFrames, metadata.height,
+                metadata.width, metadata.channels, params[0]);
+        }
+    } else if (strcmp(function, "transpose") == 0) {
+        transpose(inputFile, outputFile, metadata.numFrames,
+            metadata.height, metadata.width, metadata.channels);
+    } else if (strcmp(function, "filter") == 0) {
+        if (param_count != 2) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Parse filter type and its sigma or sharpening amount
+        float strength = atof(params[1]);
+        filter_video(inputFile, outputFile, metadata.numFrames,
+            metadata.height, metadata.width, metadata.channels,
+            params[0], strength);
+    } else if (strcmp(function, "temporal_denoise") == 0) {
+        if (param_count != 1 && param_count != 2) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Average or median over a sliding window of 2 * radius + 1 frames
+        int radius = atoi(params[0]);
+        temporal_denoise(inputFile, outputFile, metadata.numFrames,
+            metadata.height, metadata.width, metadata.channels, radius,
+            param_count == 2 ? params[1] : NULL);
+    } else if (strcmp(function, "stats") == 0) {
+        // Read-only pass producing per-frame and whole-file statistics
+        video_stats(inputFile, outputFile, metadata.numFrames,
+            metadata.height, metadata.width, metadata.channels);
+    } else if (strcmp(function, "auto_levels") == 0
+            || strcmp(function, "equalize") == 0) {
+        if (param_count > 1
+                || (param_count == 0 && strcmp(function, "auto_levels") == 0)) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Histogram pass followed by a lookup table pass
+        const char *channelStr = param_count == 1 ? params[0] : NULL;
+        if (strcmp(function, "auto_levels") == 0) {
+            auto_levels(inputFile, outputFile, metadata.numFrames,
+                metadata.height, metadata.width, metadata.channels,
+                channelStr);
+        } else {
+            equalize(inputFile, outputFile, metadata.numFrames,
+                metadata.height, metadata.width, metadata.channels,
+                channelStr);
+        }
+    } else if (strcmp(function, "to_yuv") == 0) {
+        if (param_count > 2) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Defaults to BT.601 with 4:2:0 chroma
+        to_yuv(inputFile, outputFile, metadata.numFrames, metadata.height,
+            metadata.width, metadata.channels,
+            param_count >= 1 ? params[0] : NULL,
+            param_count == 2 ? params[1] : NULL);
+    } else if (strcmp(function, "to_rgb") == 0) {
+        // Matrix and subsampling come from the input header
+        to_rgb(inputFile, outputFile, &metadata);
+    } else if (strcmp(function, "to_packed") == 0) {
+        // Interleaved pixels, as image libraries and encoders expect
+        to_packed(inputFile, outputFile, &metadata);
+    } else if (strcmp(function, "to_planar") == 0) {
+        to_planar(inputFile, outputFile, &metadata);
+    } else if (strcmp(function, "scene_index") == 0) {
+        if (param_count > 1) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Mean absolute difference per pixel that marks a cut
+        float threshold = param_count == 1 ? atof(params[0]) : 30.0f;
+        scene_index(inputFile, outputFile, metadata.numFrames,
+            metadata.height, metadata.width, metadata.channels, threshold);
+    } else if (strcmp(function, "dedupe") == 0) {
+        if (param_count != 1) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        dedupe(inputFile, outputFile, metadata.numFrames, metadata.height,
+            metadata.width, metadata.channels, atof(params[0]));
+    } else if (strcmp(function, "compress") == 0) {
+        if (param_count > 1) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Keyframe every gop size frames, deltas in between
+        int gopSize = param_count == 1 ? atoi(params[0]) : 30;
+        compress_video(inputFile, outputFile, &metadata, gopSize);
+    } else if (strcmp(function, "decompress") == 0) {
+        decompress_video(inputFile, outputFile, &metadata);
+    } else if (strcmp(function, "trim") == 0) {
+        if (param_count != 2) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Keeps frames [start, end)
+        trim(inputFile, outputFile, &metadata, atoll(params[0]),
+            atoll(params[1]));
+    } else if (strcmp(function, "concat") == 0) {
+        if (param_count < 1) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        concat(inputFile, outputFile, &metadata, params, param_count);
+    } else if (strcmp(function, "splice") == 0) {
+        if (param_count != 3) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Replaces frames [start, end) with the clip, start == end inserts
+        splice(inputFile, outputFile, &metadata, atoll(params[0]),
+            atoll(params[1]), params[2]);
+    } else if (strcmp(function, "crossfade") == 0) {
+        if (param_count != 2) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // The input's last frames fade into the clip's first ones
+        crossfade(inputFile, outputFile, &metadata, params[0],
+            atoll(params[1]));
+    } else if (strcmp(function, "overlay") == 0) {
+        if (param_count != 2) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Both files are read in step, a batch ahead of the blending
+        overlay(inputFile, outputFile, &metadata, params[0], params[1]);
+    } else if (strcmp(function, "render") == 0) {
+        FILE *edlFile = param_count == 1 ? fopen(params[0], "r") : NULL;
+        if (!edlFile) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Edits are composed first, then every output frame is made from
+        // one read of its source frame
+        EditList *edl = edl_create(inputFile, &metadata);
+        int status = edl_load(edl, edlFile);
+        fclose(edlFile);
+        if (status != 0) {
+            edl_free(edl);
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        edl_render(edl, outputFile);
+        edl_free(edl);
+    } else if (strcmp(function, "frames") == 0) {
+        if (param_count != 1) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Frames are looked up by number through the random access reader
+        extract_frames(inputFilePath, outputFile, params[0]);
+    } else if (strcmp(function, "proxies") == 0) {
+        if (param_count != 1) {
+            print_usage();
+            fclose(inputFile);
+            fclose(outputFile);
+            return 1;
+        }
+        // Half, quarter, eighth... scale copies from one read of the input
+        proxies(inputFile, outputFile, outputFilePath, &metadata,
+            atoi(params[0]));
     } else {
         fprintf(stderr, "Invalid function: %s\n", function);
         print_usage();
@@ -210,7 +684,20 @@ int main(int argc, char *argv[]) {
     }
 
     fclose(inputFile);
-    fclose(outputFile);
+    // Spilled output goes down the pipe now that its header is final
+    int closeStatus = spillOutput ? close_spill_output(outputFile, outputFd)
+                                  : fclose(outputFile);
+    if (closeStatus != 0 && (frameRange || streamOutput)) {
+        perror("Error writing output file");
+        return 1;
+    }
+    // The header is written last, once every shard is in place
+    if (finalize && finalize_shard_output(outputFilePath, &plan,
+            &shardHeader) != 0) {
+        return 1;
+    }
+    // Every buffer is back in the pool by now, hand them to the system
+    pool_trim();
 
     gettimeofday(&end_time, NULL);         // End timing
     getrusage(RUSAGE_SELF, &usage_end);   // End resource tracking
@@ -221,6 +708,7 @@ int main(int argc, char *argv[]) {
 
     printf("Elapsed time: %.6f seconds\n", elapsed_time);
     printf("Memory used: %ld KB\n", memory_used);
+    printf("Buffer pool high-water mark: %zu KB\n", pool_high_water() / 1024);
 
     return 0;
 }
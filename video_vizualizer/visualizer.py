@@ -1,43 +1,29 @@
-import struct
 import os
+import sys
 from PIL import Image
 
-def read_binary_video_file(input_file):
-    with open('rose_s.bin', 'rb') as f:
-        # Read the header
-        num_frames = struct.unpack('Q', f.read(8))[0]
-        channels = struct.unpack('B', f.read(1))[0]
-        height = struct.unpack('B', f.read(1))[0]
-        width = struct.unpack('B', f.read(1))[0]
-        print(f"Number of frames: {num_frames}, Channels: {channels}, Height: {height}, Width: {width}")
-
-        # Verify the data format
-        if channels != 3:
-            raise ValueError("Unsupported format: only 3 channels (RGB) are supported")
-
-        # Read each frame
-        frame_size = height * width * channels
-        frames = []
-
-        for _ in range(num_frames-1):
-            # Read and split the frame data into R, G, B channels
-            red_channel = f.read(height * width)
-            green_channel = f.read(height * width)
-            blue_channel = f.read(height * width)
+# The bindings live next to libFilmMaster2000.so in the repository root
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                os.pardir))
+from filmmaster2000 import Video  # noqa: E402
 
-            if len(red_channel) != height * width or len(green_channel) != height * width or len(blue_channel) != height * width:
-                raise ValueError("Unexpected EOF while reading frame data")
-
-            # Combine the channels into interleaved RGB format
-            frame_data = bytearray(height * width * channels)
-            for i in range(height * width):
-                frame_data[i * 3] = red_channel[i]
-                frame_data[i * 3 + 1] = green_channel[i]
-                frame_data[i * 3 + 2] = blue_channel[i]
-
-            frames.append((channels, height, width, frame_data))
-
-        return frames
+def read_binary_video_file(input_file):
+    # The file is memory mapped and each frame interleaved by the library,
+    # instead of unpacking pixels one at a time in Python
+    video = Video(input_file)
+    print(f"Number of frames: {video.num_frames}, Channels: {video.channels}, Height: {video.height}, Width: {video.width}")
+
+    # Verify the data format
+    if video.channels != 3:
+        raise ValueError("Unsupported format: only 3 channels (RGB) are supported")
+
+    frames = []
+    for i in range(video.num_frames):
+        frames.append((video.channels, video.height, video.width,
+                       video.interleaved(i)))
+
+    video.close()
+    return frames
 
 def save_frames_as_jpeg(frames, output_dir):
     os.makedirs(output_dir, exist_ok=True)